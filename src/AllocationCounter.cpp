@@ -0,0 +1,51 @@
+#include <cstdlib>
+#include <new>
+
+#include "AllocationCounter.h"
+
+#ifdef WEIGHT_RETARGETING_COUNT_ALLOCATIONS
+
+namespace
+{
+    thread_local std::size_t threadAllocationCount = 0;
+
+    void* countedAllocation(std::size_t size)
+    {
+        threadAllocationCount++;
+        void* pointer = std::malloc(size==0 ? 1 : size);
+        if(pointer==nullptr)
+            throw std::bad_alloc();
+        return pointer;
+    }
+}
+
+void* operator new(std::size_t size) { return countedAllocation(size); }
+void* operator new[](std::size_t size) { return countedAllocation(size); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+std::size_t AllocationCounter::getThreadCount()
+{
+    return threadAllocationCount;
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+std::size_t AllocationCounter::getThreadCount()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,63 @@
+#include <yarp/os/Bottle.h>
+
+#include "BatchedActuationCommand.h"
+
+void BatchedActuationCommand::clear(const ActuatorNames& actuatorNames)
+{
+    if(this->actuatorNames!=actuatorNames)
+        this->actuatorNames = actuatorNames;
+    commands.clear();
+    commands.reserve(actuatorNames->size());
+}
+
+bool BatchedActuationCommand::read(yarp::os::ConnectionReader& reader)
+{
+    yarp::os::Bottle message;
+    if(!message.read(reader))
+        return false;
+
+    auto names = std::make_shared<std::vector<std::string>>();
+    commands.clear();
+    for(size_t i=0; i<message.size(); i++)
+    {
+        yarp::os::Bottle* command = message.get(i).asList();
+        if(command==nullptr || command->size()!=2 || !command->get(0).isString())
+            return false;
+        names->push_back(command->get(0).asString());
+        commands.push_back({i, command->get(1).asFloat64()});
+    }
+    actuatorNames = names;
+    return true;
+}
+
+bool BatchedActuationCommand::write(yarp::os::ConnectionWriter& writer) const
+{
+    // the text connections are rare, they are served by a Bottle
+    if(writer.isTextMode())
+    {
+        yarp::os::Bottle message;
+        for(const Command& command : commands)
+        {
+            yarp::os::Bottle& actuatorCommand = message.addList();
+            actuatorCommand.addString((*actuatorNames)[command.actuator]);
+            actuatorCommand.addFloat64(command.intensity);
+        }
+        return message.write(writer);
+    }
+
+    // a list of lists, each of them with a string and a float, without specialization
+    writer.appendInt32(BOTTLE_TAG_LIST);
+    writer.appendInt32(static_cast<std::int32_t>(commands.size()));
+    for(const Command& command : commands)
+    {
+        const std::string& actuator = (*actuatorNames)[command.actuator];
+        writer.appendInt32(BOTTLE_TAG_LIST);
+        writer.appendInt32(2);
+        writer.appendInt32(BOTTLE_TAG_STRING);
+        writer.appendInt32(static_cast<std::int32_t>(actuator.size()));
+        writer.appendBlock(actuator.data(), actuator.size());
+        writer.appendInt32(BOTTLE_TAG_FLOAT64);
+        writer.appendFloat64(command.intensity);
+    }
+    return !writer.isError();
+}
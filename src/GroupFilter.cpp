@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include "GroupFilter.h"
+
+GroupFilter::Type GroupFilter::typeFromString(const std::string& type)
+{
+    if(type=="none") return Type::None;
+    else if(type=="low_pass") return Type::LowPass;
+    else if(type=="moving_average") return Type::MovingAverage;
+    else if(type=="median") return Type::Median;
+    else return Type::Invalid;
+}
+
+std::string GroupFilter::typeToString(const Type type)
+{
+    switch(type)
+    {
+    case Type::None: return "none";
+    case Type::LowPass: return "low_pass";
+    case Type::MovingAverage: return "moving_average";
+    case Type::Median: return "median";
+    default: return "invalid";
+    }
+}
+
+bool GroupFilter::configure(const Type type, const double parameter)
+{
+    switch(type)
+    {
+    case Type::None:
+        break;
+    case Type::LowPass:
+        if(!(parameter>0.0 && parameter<=1.0))
+            return false;
+        alpha = parameter;
+        break;
+    case Type::MovingAverage:
+    case Type::Median:
+        if(!(parameter>=1.0 && parameter<=MAX_WINDOW) || parameter!=static_cast<double>(static_cast<size_t>(parameter)))
+            return false;
+        window = static_cast<size_t>(parameter);
+        break;
+    default:
+        return false;
+    }
+
+    this->type = type;
+    reset();
+    return true;
+}
+
+void GroupFilter::reset()
+{
+    output = 0.0;
+    next = 0;
+    count = 0;
+    sum = 0.0;
+}
+
+double GroupFilter::apply(const double value)
+{
+    switch(type)
+    {
+    case Type::LowPass:
+    {
+        // the first sample initializes the filter, avoiding a ramp from zero
+        output = count==0 ? value : output + alpha*(value-output);
+        count = 1;
+        return output;
+    }
+    case Type::MovingAverage:
+    {
+        if(count==window)
+            sum -= samples[next];
+        else
+            count++;
+        samples[next] = value;
+        sum += value;
+        next = (next+1)%window;
+
+        // recompute the sum when the ring buffer wraps, so that the rounding errors do not accumulate
+        if(next==0 && count==window)
+        {
+            sum = 0.0;
+            for(size_t i=0; i<window; i++)
+                sum += samples[i];
+        }
+        return sum/count;
+    }
+    case Type::Median:
+    {
+        samples[next] = value;
+        next = (next+1)%window;
+        if(count<window)
+            count++;
+
+        // the window is small, so the samples are sorted on a copy on the stack
+        std::array<double, MAX_WINDOW> sorted;
+        std::copy(samples.begin(), samples.begin()+count, sorted.begin());
+        std::sort(sorted.begin(), sorted.begin()+count);
+        return count%2==1 ? sorted[count/2] : 0.5*(sorted[count/2-1]+sorted[count/2]);
+    }
+    default:
+        return value;
+    }
+}
@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include "GroupPredictor.h"
+
+GroupPredictor::Type GroupPredictor::typeFromString(const std::string& type)
+{
+    if(type=="none") return Type::None;
+    else if(type=="linear") return Type::Linear;
+    else if(type=="kalman") return Type::Kalman;
+    else return Type::Invalid;
+}
+
+std::string GroupPredictor::typeToString(const Type type)
+{
+    switch(type)
+    {
+    case Type::None: return "none";
+    case Type::Linear: return "linear";
+    case Type::Kalman: return "kalman";
+    default: return "invalid";
+    }
+}
+
+bool GroupPredictor::configureLinear(const size_t window)
+{
+    if(window<2 || window>MAX_WINDOW)
+        return false;
+
+    type = Type::Linear;
+    this->window = window;
+    reset();
+    return true;
+}
+
+bool GroupPredictor::configureKalman(const double processNoise, const double measurementNoise)
+{
+    if(!(processNoise>0.0) || !(measurementNoise>0.0))
+        return false;
+
+    type = Type::Kalman;
+    this->processNoise = processNoise;
+    this->measurementNoise = measurementNoise;
+    reset();
+    return true;
+}
+
+void GroupPredictor::reset()
+{
+    next = 0;
+    count = 0;
+    norm = 0.0;
+    slope = 0.0;
+    p00 = p01 = p11 = 0.0;
+    lastTime = 0.0;
+}
+
+double GroupPredictor::apply(const double value, const double time, const double lead)
+{
+    double prediction;
+    switch(type)
+    {
+    case Type::Linear:
+    {
+        const size_t newest = (next+window-1)%window;
+        if(count>0 && !(time>times[newest]))
+        {
+            // same timestamp of the previous sample, only its value is updated
+            samples[newest] = value;
+        }
+        else
+        {
+            samples[next] = value;
+            times[next] = time;
+            next = (next+1)%window;
+            if(count<window)
+                count++;
+        }
+        prediction = value + computeSlope()*lead;
+        break;
+    }
+    case Type::Kalman:
+    {
+        updateKalman(value, time);
+        prediction = norm + slope*lead;
+        break;
+    }
+    default:
+        return value;
+    }
+
+    return std::max(prediction, 0.0);
+}
+
+double GroupPredictor::computeSlope() const
+{
+    if(count<2)
+        return 0.0;
+
+    // the times are taken relative to the newest sample, so that the sums do not lose precision
+    const double reference = times[(next+window-1)%window];
+    double meanTime = 0.0;
+    double meanValue = 0.0;
+    for(size_t i=0; i<count; i++)
+    {
+        meanTime += times[i]-reference;
+        meanValue += samples[i];
+    }
+    meanTime /= count;
+    meanValue /= count;
+
+    double covariance = 0.0;
+    double variance = 0.0;
+    for(size_t i=0; i<count; i++)
+    {
+        const double deltaTime = times[i]-reference-meanTime;
+        covariance += deltaTime*(samples[i]-meanValue);
+        variance += deltaTime*deltaTime;
+    }
+    return variance>0.0 ? covariance/variance : 0.0;
+}
+
+void GroupPredictor::updateKalman(const double value, const double time)
+{
+    if(count==0)
+    {
+        norm = value;
+        lastTime = time;
+        count = 1;
+        return;
+    }
+
+    const double dt = time-lastTime;
+    if(!(dt>0.0))
+        return;
+    lastTime = time;
+
+    if(count==1)
+    {
+        // initialize the state with the first two samples
+        slope = (value-norm)/dt;
+        norm = value;
+        p00 = measurementNoise;
+        p01 = measurementNoise/dt;
+        p11 = 2.0*measurementNoise/(dt*dt);
+        count = 2;
+        return;
+    }
+
+    // prediction with a constant slope, driven by a white noise on its rate of change
+    norm += slope*dt;
+    p00 += dt*(2.0*p01 + dt*p11) + processNoise*dt*dt*dt/3.0;
+    p01 += dt*p11 + processNoise*dt*dt/2.0;
+    p11 += processNoise*dt;
+
+    // correction with the measured norm
+    const double innovation = value-norm;
+    const double gain0 = p00/(p00+measurementNoise);
+    const double gain1 = p01/(p00+measurementNoise);
+    norm += gain0*innovation;
+    slope += gain1*innovation;
+    p11 -= gain1*p01;
+    p01 -= gain0*p01;
+    p00 -= gain0*p00;
+}
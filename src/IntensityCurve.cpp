@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <cmath>
+
+#include "IntensityCurve.h"
+
+IntensityCurve::Type IntensityCurve::typeFromString(const std::string& type)
+{
+    if(type=="linear") return Type::Linear;
+    else if(type=="power") return Type::Power;
+    else if(type=="log") return Type::Logarithmic;
+    else if(type=="piecewise") return Type::PiecewiseLinear;
+    else if(type=="steps") return Type::Stepped;
+    else return Type::Invalid;
+}
+
+std::string IntensityCurve::typeToString(const Type type)
+{
+    switch(type)
+    {
+    case Type::Linear: return "linear";
+    case Type::Power: return "power";
+    case Type::Logarithmic: return "log";
+    case Type::PiecewiseLinear: return "piecewise";
+    case Type::Stepped: return "steps";
+    default: return "invalid";
+    }
+}
+
+IntensityCurve::IntensityCurve()
+{
+    configure(Type::Linear, {});
+}
+
+bool IntensityCurve::configure(const Type type, const std::vector<double>& parameters)
+{
+    switch(type)
+    {
+    case Type::Linear:
+        if(!parameters.empty())
+            return false;
+        break;
+    case Type::Power:
+    case Type::Logarithmic:
+        if(parameters.size()!=1 || !(parameters[0]>0.0) || std::isinf(parameters[0]))
+            return false;
+        break;
+    case Type::Stepped:
+        if(parameters.size()!=1 || !(parameters[0]>=1.0 && parameters[0]<=WEIGHT_RETARGETING_MAX_INTENSITY) || parameters[0]!=std::floor(parameters[0]))
+            return false;
+        break;
+    case Type::PiecewiseLinear:
+        // at least two points, with the abscissas increasing in [0,1] and the ordinates in [0,1]
+        if(parameters.size()<4 || parameters.size()%2!=0)
+            return false;
+        for(size_t i=0; i<parameters.size(); i+=2)
+        {
+            if(!(parameters[i]>=0.0 && parameters[i]<=1.0 && parameters[i+1]>=0.0 && parameters[i+1]<=1.0))
+                return false;
+            if(i>0 && !(parameters[i]>parameters[i-2]))
+                return false;
+        }
+        break;
+    default:
+        return false;
+    }
+
+    this->type = type;
+    for(size_t i=0; i<=RESOLUTION; i++)
+    {
+        const double normalizedValue = static_cast<double>(i)/RESOLUTION;
+        const double normalizedIntensity = std::min(std::max(evaluate(type, parameters, normalizedValue), 0.0), 1.0);
+        table[i] = static_cast<std::uint8_t>(normalizedIntensity*WEIGHT_RETARGETING_MAX_INTENSITY);
+    }
+    return true;
+}
+
+double IntensityCurve::evaluate(const Type type, const std::vector<double>& parameters, const double normalizedValue)
+{
+    switch(type)
+    {
+    case Type::Power:
+        return std::pow(normalizedValue, parameters[0]);
+    case Type::Logarithmic:
+        return std::log1p(parameters[0]*normalizedValue)/std::log1p(parameters[0]);
+    case Type::Stepped:
+        return std::floor(normalizedValue*parameters[0])/parameters[0];
+    case Type::PiecewiseLinear:
+    {
+        // hold the ends of the curve
+        if(normalizedValue<=parameters[0])
+            return parameters[1];
+        size_t next = 2;
+        while(next<parameters.size() && parameters[next]<normalizedValue)
+            next += 2;
+        if(next>=parameters.size())
+            return parameters[parameters.size()-1];
+        const double ratio = (normalizedValue-parameters[next-2])/(parameters[next]-parameters[next-2]);
+        return parameters[next-1] + ratio*(parameters[next+1]-parameters[next-1]);
+    }
+    default:
+        return normalizedValue;
+    }
+}
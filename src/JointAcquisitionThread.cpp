@@ -0,0 +1,237 @@
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Time.h>
+
+#include "JointAcquisitionThread.h"
+#include "ParallelBoardReader.h"
+#include "WeightRetargetingLogComponent.h"
+#include "WrenchAcquisition.h"
+
+bool JointAcquisition::configure(yarp::dev::PolyDriver& controlBoard, const RetargetedValue retargetedValue, const bool useVelocities, const size_t numberOfJoints,
+                                 const WeightAcquisition* weightAcquisition)
+{
+    this->retargetedValue = retargetedValue;
+    this->useVelocities = useVelocities;
+    boardReader = nullptr;
+
+    // get the interface related to the corresponding retargeted value
+    bool result = false;
+    switch(retargetedValue)
+    {
+    case RetargetedValue::JointTorque: result = controlBoard.view(iTorqueControl); break;
+    case RetargetedValue::MotorCurrent: result = controlBoard.view(iCurrentControl); break;
+    default : result = false;
+    }
+
+    if(!result)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get torque control interface";
+        return false;
+    }
+
+    // get the interface for the velocity if needed
+    if(useVelocities && !controlBoard.view(iEncodersTimed))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get encodersTimed interface";
+        return false;
+    }
+
+    // get the timestamps of the data if available
+    if(!controlBoard.view(iPreciselyTimed))
+    {
+        iPreciselyTimed = nullptr;
+        yCIWarning(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The control board does not provide timestamps, the time of the reading will be used";
+    }
+
+    allocateSamples(numberOfJoints, weightAcquisition);
+    return true;
+}
+
+bool JointAcquisition::configure(ParallelBoardReader& boardReader, const bool useVelocities, const size_t numberOfJoints, const WeightAcquisition* weightAcquisition)
+{
+    this->boardReader = &boardReader;
+    this->useVelocities = useVelocities;
+
+    allocateSamples(numberOfJoints, weightAcquisition);
+    return true;
+}
+
+bool JointAcquisition::configure(const WeightAcquisition& weightAcquisition)
+{
+    retargetedValue = RetargetedValue::Weight;
+    useVelocities = false;
+    boardReader = nullptr;
+
+    allocateSamples(0, &weightAcquisition);
+    return true;
+}
+
+void JointAcquisition::allocateSamples(const size_t numberOfJoints, const WeightAcquisition* weightAcquisition)
+{
+    this->numberOfJoints = numberOfJoints;
+    this->weightAcquisition = weightAcquisition;
+
+    // the velocity of the weight is always null
+    const size_t numberOfValues = numberOfJoints + (weightAcquisition!=nullptr ? 1 : 0);
+    JointSample sample;
+    sample.interfaceValues.resize(numberOfValues);
+    sample.velocities.assign(numberOfValues, 0.0);
+    samples.initialize(sample);
+    lastVelocities.assign(numberOfValues, 0.0);
+}
+
+bool JointAcquisition::updateSample()
+{
+    return samples.update();
+}
+
+const JointAcquisition::JointSample& JointAcquisition::getSample() const
+{
+    return samples.getReadBuffer();
+}
+
+bool JointAcquisition::readFromBoards(JointSample& sample)
+{
+    double startTime = yarp::os::Time::now();
+
+    ParallelBoardReader::Reading reading;
+    reading.values = sample.interfaceValues.data();
+    reading.velocities = useVelocities ? sample.velocities.data() : nullptr;
+    boardReader->read(reading);
+    if(!reading.valuesRead)
+        return false;
+
+    // the velocities are read together with the values, so the acquisition includes them
+    sample.time = yarp::os::Time::now();
+    sample.acquisitionDuration = sample.time - startTime;
+    sample.measurementTime = reading.measurementTime;
+    sample.velocityReadDuration = reading.velocityReadDuration;
+    if(useVelocities)
+    {
+        if(reading.velocitiesRead)
+            std::copy(sample.velocities.begin(), sample.velocities.end(), lastVelocities.begin());
+        else
+            std::copy(lastVelocities.begin(), lastVelocities.end(), sample.velocities.begin());
+    }
+    return true;
+}
+
+void JointAcquisition::readWeight(JointSample& sample)
+{
+    sample.interfaceValues[0] = weightAcquisition->getWeight();
+    sample.time = yarp::os::Time::now();
+    sample.acquisitionDuration = 0.0;
+    sample.measurementTime = weightAcquisition->getMeasurementTime();
+    sample.velocityReadDuration = 0.0;
+}
+
+void JointAcquisition::acquire()
+{
+    JointSample& sample = samples.getWriteBuffer();
+    if(retargetedValue==RetargetedValue::Weight)
+    {
+        // the weight has been updated by the acquisition thread
+        readWeight(sample);
+        samples.publish();
+        return;
+    }
+
+    if(boardReader!=nullptr)
+    {
+        // publish the sample only if acquisition is successful
+        if(readFromBoards(sample))
+        {
+            if(weightAcquisition!=nullptr)
+                sample.interfaceValues[numberOfJoints] = weightAcquisition->getWeight();
+            samples.publish();
+        }
+        return;
+    }
+
+    double startTime = yarp::os::Time::now();
+
+    // get the data
+    bool acquisitionResult = false;
+    switch (retargetedValue)
+    {
+    case RetargetedValue::JointTorque : acquisitionResult = iTorqueControl->getTorques(sample.interfaceValues.data()); break;
+    case RetargetedValue::MotorCurrent : acquisitionResult = iCurrentControl->getCurrents(sample.interfaceValues.data()); break;
+    default: acquisitionResult = false; break;
+    }
+
+    // publish the sample only if acquisition is successful
+    if(!acquisitionResult)
+        return;
+
+    sample.time = yarp::os::Time::now();
+    sample.acquisitionDuration = sample.time - startTime;
+
+    // use the timestamp of the control board, if valid
+    sample.measurementTime = startTime;
+    if(iPreciselyTimed!=nullptr)
+    {
+        yarp::os::Stamp stamp = iPreciselyTimed->getLastInputStamp();
+        if(stamp.isValid())
+            sample.measurementTime = stamp.getTime();
+    }
+
+    // get the velocities, keeping the last ones if their acquisition fails
+    sample.velocityReadDuration = 0.0;
+    if(useVelocities)
+    {
+        if(iEncodersTimed->getEncoderSpeeds(sample.velocities.data()))
+            std::copy(sample.velocities.begin(), sample.velocities.end(), lastVelocities.begin());
+        else
+            std::copy(lastVelocities.begin(), lastVelocities.end(), sample.velocities.begin());
+        sample.velocityReadDuration = yarp::os::Time::now() - sample.time;
+    }
+
+    // the weight has been updated by the acquisition thread
+    if(weightAcquisition!=nullptr)
+        sample.interfaceValues[numberOfJoints] = weightAcquisition->getWeight();
+
+    samples.publish();
+}
+
+JointAcquisitionThread::JointAcquisitionThread(const double period) : yarp::os::PeriodicThread(period)
+{
+}
+
+void JointAcquisitionThread::add(JointAcquisition& acquisition)
+{
+    std::lock_guard<std::mutex> guard(acquisitionsMutex);
+    acquisitions.push_back(&acquisition);
+}
+
+void JointAcquisitionThread::remove(JointAcquisition& acquisition)
+{
+    {
+        std::lock_guard<std::mutex> guard(acquisitionsMutex);
+        acquisitions.erase(std::remove(acquisitions.begin(), acquisitions.end(), &acquisition), acquisitions.end());
+    }
+
+    // wait for the end of its current reading, the other acquisitions are not waited for
+    std::lock_guard<std::mutex> guard(acquisition.acquireMutex);
+}
+
+void JointAcquisitionThread::run()
+{
+    // the wrenches are read once for all of the acquisitions retargeting the weight
+    if(weightAcquisition!=nullptr)
+        weightAcquisition->update();
+
+    // the lock of an acquisition is taken before releasing the list, so that a removed acquisition is never read after remove returns.
+    // Removing an acquisition during the cycle shifts the list, so the following one can be skipped until the next cycle.
+    for(size_t i=0; ; i++)
+    {
+        std::unique_lock<std::mutex> acquisitionsLock(acquisitionsMutex);
+        if(i>=acquisitions.size())
+            break;
+        JointAcquisition& acquisition = *acquisitions[i];
+        std::lock_guard<std::mutex> acquisitionGuard(acquisition.acquireMutex);
+        acquisitionsLock.unlock();
+
+        acquisition.acquire();
+    }
+}
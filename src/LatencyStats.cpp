@@ -0,0 +1,108 @@
+#include <cmath>
+
+#include "LatencyStats.h"
+
+namespace
+{
+    // Index of the most significant bit of a non-zero value
+    int getMostSignificantBit(uint64_t value)
+    {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while(value>>=1)
+            bit++;
+        return bit;
+#endif
+    }
+}
+
+size_t LatencyHistogram::getBucketIndex(const uint64_t value)
+{
+    // the values below 2*SUB_BUCKETS have a bucket each
+    if(value<2*SUB_BUCKETS)
+        return static_cast<size_t>(value);
+
+    // the other values are grouped by their SUB_BUCKET_BITS+1 most significant bits
+    const int shift = getMostSignificantBit(value) - SUB_BUCKET_BITS;
+    return static_cast<size_t>(shift)*SUB_BUCKETS + static_cast<size_t>(value>>shift);
+}
+
+uint64_t LatencyHistogram::getBucketHighestValue(const size_t index)
+{
+    if(index<2*SUB_BUCKETS)
+        return index;
+
+    const int shift = static_cast<int>(index/SUB_BUCKETS) - 1;
+    const uint64_t top = index - static_cast<size_t>(shift)*SUB_BUCKETS;
+    return ((top+1)<<shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanoseconds)
+{
+    if(nanoseconds>MAX_VALUE)
+        nanoseconds = MAX_VALUE;
+
+    buckets[getBucketIndex(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    if(nanoseconds>max.load(std::memory_order_relaxed))
+        max.store(nanoseconds, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::recordSeconds(const double seconds)
+{
+    record(seconds>0 ? static_cast<uint64_t>(std::llround(seconds*1e9)) : 0);
+}
+
+double LatencyHistogram::getPercentile(const double percentile) const
+{
+    // the buckets are summed instead of using count, so that the result is consistent with a concurrent writer
+    uint64_t total = 0;
+    for(const std::atomic<uint64_t>& bucket : buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    if(total==0)
+        return 0.0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile/100.0*total));
+    if(rank==0)
+        rank = 1;
+
+    uint64_t cumulative = 0;
+    for(size_t i=0; i<NUMBER_OF_BUCKETS; i++)
+    {
+        cumulative += buckets[i].load(std::memory_order_relaxed);
+        if(cumulative>=rank)
+            return getBucketHighestValue(i)*1e-9;
+    }
+    return getMax();
+}
+
+void LatencyHistogram::reset()
+{
+    for(std::atomic<uint64_t>& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+std::string LatencyStats::stageToString(const Stage stage)
+{
+    switch(stage)
+    {
+    case Stage::Acquire: return "acquire";
+    case Stage::VelocityRead: return "velocity_read";
+    case Stage::Compute: return "compute";
+    case Stage::Serialize: return "serialize";
+    case Stage::Write: return "write";
+    case Stage::EndToEnd: return "end_to_end";
+    case Stage::PredictionLead: return "prediction_lead";
+    default: return "invalid";
+    }
+}
+
+void LatencyStats::reset()
+{
+    for(LatencyHistogram& histogram : histograms)
+        histogram.reset();
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
+#include <yarp/dev/IAxisInfo.h>
+
+#include "ParallelBoardReader.h"
+#include "WeightRetargetingLogComponent.h"
+
+ParallelBoardReader::~ParallelBoardReader()
+{
+    close();
+}
+
+bool ParallelBoardReader::open(const std::vector<std::string>& remoteBoards, const std::string& localPortPrefix, const std::vector<std::string>& jointNames,
+                               const RetargetedValue retargetedValue, const bool useVelocities, TaskPool& pool)
+{
+    close();
+    this->retargetedValue = retargetedValue;
+    this->useVelocities = useVelocities;
+    this->pool = &pool;
+
+    // open the boards, keeping only the ones with some of the joints
+    std::vector<bool> jointFound(jointNames.size(), false);
+    for(const std::string& remoteBoard : remoteBoards)
+    {
+        std::unique_ptr<Board> board = std::make_unique<Board>();
+        board->name = remoteBoard;
+        if(!openBoard(*board, localPortPrefix, jointNames, jointFound))
+        {
+            close();
+            return false;
+        }
+
+        if(std::all_of(board->jointIndexes.begin(), board->jointIndexes.end(), [](const int index){ return index<0; }))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The control board" << remoteBoard << "has none of the retargeted joints and it will not be read";
+            board->driver.close();
+            continue;
+        }
+        boards.push_back(std::move(board));
+    }
+
+    for(size_t i=0; i<jointNames.size(); i++)
+    {
+        if(!jointFound[i])
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The joint" << jointNames[i] << "has not been found on the control boards";
+            close();
+            return false;
+        }
+    }
+
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Reading" << boards.size() << "control boards with" << pool.getNumberOfThreads() << "threads";
+    return true;
+}
+
+bool ParallelBoardReader::openBoard(Board& board, const std::string& localPortPrefix, const std::vector<std::string>& jointNames, std::vector<bool>& jointFound)
+{
+    yarp::os::Property options;
+    options.put("device", "remote_controlboard");
+    options.put("remote", board.name);
+    options.put("local", localPortPrefix+board.name);
+    options.put("writeStrict", "off");
+    if(!board.driver.open(options))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the control board" << board.name;
+        return false;
+    }
+
+    // get the interface related to the retargeted value and the number of axes
+    int numberOfAxes = 0;
+    bool result = false;
+    switch(retargetedValue)
+    {
+    case RetargetedValue::JointTorque: result = board.driver.view(board.iTorqueControl) && board.iTorqueControl->getAxes(&numberOfAxes); break;
+    case RetargetedValue::MotorCurrent: result = board.driver.view(board.iCurrentControl) && board.iCurrentControl->getNumberOfMotors(&numberOfAxes); break;
+    default : result = false;
+    }
+    if(!result)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get the interface of the retargeted value of" << board.name;
+        return false;
+    }
+
+    if(useVelocities && !board.driver.view(board.iEncodersTimed))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get encodersTimed interface of" << board.name;
+        return false;
+    }
+
+    if(!board.driver.view(board.iPreciselyTimed))
+        board.iPreciselyTimed = nullptr;
+
+    // map the axes to the joints, a joint available on several boards is read from the first one
+    yarp::dev::IAxisInfo* iAxisInfo{nullptr};
+    if(!board.driver.view(iAxisInfo))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get axisInfo interface of" << board.name;
+        return false;
+    }
+
+    board.jointIndexes.assign(numberOfAxes, -1);
+    for(int axis=0; axis<numberOfAxes; axis++)
+    {
+        std::string axisName;
+        if(!iAxisInfo->getAxisName(axis, axisName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get the name of the axis" << axis << "of" << board.name;
+            return false;
+        }
+
+        auto it = std::find(jointNames.begin(), jointNames.end(), axisName);
+        if(it==jointNames.end())
+            continue;
+
+        const size_t joint = it - jointNames.begin();
+        if(jointFound[joint])
+            continue;
+        jointFound[joint] = true;
+        board.jointIndexes[axis] = static_cast<int>(joint);
+    }
+
+    board.values.resize(numberOfAxes);
+    board.velocities.resize(numberOfAxes);
+    return true;
+}
+
+void ParallelBoardReader::close()
+{
+    for(std::unique_ptr<Board>& board : boards)
+        board->driver.close();
+    boards.clear();
+}
+
+void ParallelBoardReader::read(Reading& reading)
+{
+    currentReading = &reading;
+    pool->run(*this, boards.size());
+    currentReading = nullptr;
+
+    // merge the results of the boards
+    reading.valuesRead = true;
+    reading.velocitiesRead = true;
+    reading.velocityReadDuration = 0.0;
+    for(size_t i=0; i<boards.size(); i++)
+    {
+        const Board& board = *boards[i];
+        reading.valuesRead = reading.valuesRead && board.valuesRead;
+        reading.velocitiesRead = reading.velocitiesRead && board.velocitiesRead;
+        reading.measurementTime = i==0 ? board.measurementTime : std::min(reading.measurementTime, board.measurementTime);
+        reading.velocityReadDuration = std::max(reading.velocityReadDuration, board.velocityReadDuration);
+    }
+}
+
+void ParallelBoardReader::runTask(const size_t task)
+{
+    readBoard(*boards[task], *currentReading);
+}
+
+void ParallelBoardReader::readBoard(Board& board, Reading& reading)
+{
+    double startTime = yarp::os::Time::now();
+
+    switch(retargetedValue)
+    {
+    case RetargetedValue::JointTorque : board.valuesRead = board.iTorqueControl->getTorques(board.values.data()); break;
+    case RetargetedValue::MotorCurrent : board.valuesRead = board.iCurrentControl->getCurrents(board.values.data()); break;
+    default: board.valuesRead = false; break;
+    }
+
+    // use the timestamp of the control board, if valid
+    board.measurementTime = startTime;
+    if(board.iPreciselyTimed!=nullptr)
+    {
+        yarp::os::Stamp stamp = board.iPreciselyTimed->getLastInputStamp();
+        if(stamp.isValid())
+            board.measurementTime = stamp.getTime();
+    }
+
+    board.velocitiesRead = true;
+    board.velocityReadDuration = 0.0;
+    if(useVelocities && reading.velocities!=nullptr)
+    {
+        double velocityStartTime = yarp::os::Time::now();
+        board.velocitiesRead = board.iEncodersTimed->getEncoderSpeeds(board.velocities.data());
+        board.velocityReadDuration = yarp::os::Time::now() - velocityStartTime;
+    }
+
+    // each joint belongs to a single board, so the boards scatter their values without synchronization
+    for(size_t axis=0; axis<board.jointIndexes.size(); axis++)
+    {
+        const int joint = board.jointIndexes[axis];
+        if(joint<0)
+            continue;
+        if(board.valuesRead)
+            reading.values[joint] = board.values[axis];
+        if(board.velocitiesRead && reading.velocities!=nullptr)
+            reading.velocities[joint] = board.velocities[axis];
+    }
+
+    board.readTimes.recordSeconds(yarp::os::Time::now() - startTime);
+}
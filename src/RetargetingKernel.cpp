@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "RetargetingKernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WEIGHT_RETARGETING_KERNEL_X86
+#include <immintrin.h>
+#define WEIGHT_RETARGETING_TARGET_SSE2 __attribute__((target("sse2")))
+#define WEIGHT_RETARGETING_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define WEIGHT_RETARGETING_KERNEL_X86
+#include <immintrin.h>
+#include <intrin.h>
+#define WEIGHT_RETARGETING_TARGET_SSE2
+#define WEIGHT_RETARGETING_TARGET_AVX2
+#endif
+
+RetargetingKernel::InstructionSet RetargetingKernel::detectInstructionSet()
+{
+#if defined(__GNUC__) && defined(WEIGHT_RETARGETING_KERNEL_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+        return InstructionSet::AVX2;
+    if(__builtin_cpu_supports("sse2"))
+        return InstructionSet::SSE2;
+#elif defined(WEIGHT_RETARGETING_KERNEL_X86)
+    // AVX2 requires the CPU support (leaf 7) and the OS support for the YMM registers (OSXSAVE and XCR0)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool osSupportsAVX = (info[2] & (1<<27)) && (info[2] & (1<<28)) && ((_xgetbv(0) & 0x6) == 0x6);
+    if(osSupportsAVX && maxLeaf>=7)
+    {
+        __cpuidex(info, 7, 0);
+        if(info[1] & (1<<5))
+            return InstructionSet::AVX2;
+    }
+    // SSE2 is part of the x86-64 baseline
+    return InstructionSet::SSE2;
+#endif
+    return InstructionSet::Scalar;
+}
+
+std::string RetargetingKernel::instructionSetToString(const InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+    case InstructionSet::SSE2: return "SSE2";
+    case InstructionSet::AVX2: return "AVX2";
+    default: return "scalar";
+    }
+}
+
+void RetargetingKernel::configure(const std::vector<int>& jointOffsets, const std::vector<int>& jointIndexes, const size_t numberOfJoints, const InstructionSet instructionSet)
+{
+    this->numberOfJoints = numberOfJoints;
+    this->numberOfGroups = jointOffsets.size()-1;
+
+#ifdef WEIGHT_RETARGETING_KERNEL_X86
+    this->instructionSet = instructionSet;
+#else
+    this->instructionSet = InstructionSet::Scalar;
+#endif
+
+    switch(this->instructionSet)
+    {
+    case InstructionSet::SSE2: width = 2; break;
+    case InstructionSet::AVX2: width = 4; break;
+    default: width = 1; break;
+    }
+
+    // build the dependency graph, sharing the norm among the groups with the same list of joints.
+    // The order of the joints is kept, so that the sum is the same of the single group.
+    std::map<std::vector<int>, int> normMap;
+    groupNorms.clear();
+    normOffsets.assign(1, 0);
+    normIndexes.clear();
+    for(size_t group=0; group<numberOfGroups; group++)
+    {
+        std::vector<int> joints(jointIndexes.begin()+jointOffsets[group], jointIndexes.begin()+jointOffsets[group+1]);
+        auto it = normMap.find(joints);
+        if(it==normMap.end())
+        {
+            it = normMap.emplace(joints, static_cast<int>(normOffsets.size()-1)).first;
+            normIndexes.insert(normIndexes.end(), joints.begin(), joints.end());
+            normOffsets.push_back(normIndexes.size());
+        }
+        groupNorms.push_back(it->second);
+    }
+    numberOfNorms = normOffsets.size()-1;
+
+    // build the interleaved layout of the blocks
+    const size_t numberOfBlocks = (numberOfNorms+width-1)/width;
+    const int paddingIndex = static_cast<int>(numberOfJoints);
+    blockOffsets.assign(1, 0);
+    blockIndexes.clear();
+    for(size_t block=0; block<numberOfBlocks; block++)
+    {
+        int rows = 0;
+        for(size_t norm=block*width; norm<std::min((block+1)*width, numberOfNorms); norm++)
+            rows = std::max(rows, normOffsets[norm+1]-normOffsets[norm]);
+
+        for(int row=0; row<rows; row++)
+        {
+            for(size_t lane=0; lane<width; lane++)
+            {
+                const size_t norm = block*width+lane;
+                if(norm<numberOfNorms && normOffsets[norm]+row<normOffsets[norm+1])
+                    blockIndexes.push_back(normIndexes[normOffsets[norm]+row]);
+                else
+                    blockIndexes.push_back(paddingIndex);
+            }
+        }
+        blockOffsets.push_back(blockOffsets.back()+rows);
+    }
+
+    squares.assign(numberOfJoints+1, 0.0);
+    norms.assign(numberOfBlocks*width, 0.0);
+    groupNormBuffer.assign(numberOfGroups, 0.0);
+}
+
+void RetargetingKernel::computeNorms(const double* interfaceValues, double* groupNorms)
+{
+    // square each joint once, the last square is kept to zero for the padding
+    for(size_t joint=0; joint<numberOfJoints; joint++)
+    {
+        squares[joint] = interfaceValues[joint] * interfaceValues[joint];
+    }
+
+    switch(instructionSet)
+    {
+    case InstructionSet::AVX2: computeNormsAVX2(); break;
+    case InstructionSet::SSE2: computeNormsSSE2(); break;
+    default: computeNormsScalar(); break;
+    }
+
+    // distribute the shared norms to the groups
+    for(size_t group=0; group<numberOfGroups; group++)
+    {
+        groupNorms[group] = norms[this->groupNorms[group]];
+    }
+}
+
+void RetargetingKernel::computeIntensities(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    switch(instructionSet)
+    {
+    case InstructionSet::AVX2: computeIntensitiesAVX2(groupNorms, offsets, minThresholds, maxThresholds, intensities); break;
+    case InstructionSet::SSE2: computeIntensitiesSSE2(groupNorms, offsets, minThresholds, maxThresholds, intensities); break;
+    default: computeIntensitiesScalar(0, groupNorms, offsets, minThresholds, maxThresholds, intensities); break;
+    }
+}
+
+void RetargetingKernel::compute(const double* interfaceValues, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    computeNorms(interfaceValues, groupNormBuffer.data());
+    computeIntensities(groupNormBuffer.data(), offsets, minThresholds, maxThresholds, intensities);
+}
+
+void RetargetingKernel::computeNormsScalar()
+{
+    for(size_t norm=0; norm<numberOfNorms; norm++)
+    {
+        double sum = 0;
+        for(int i=normOffsets[norm]; i<normOffsets[norm+1]; i++)
+        {
+            sum += squares[normIndexes[i]];
+        }
+        norms[norm] = std::sqrt(sum);
+    }
+}
+
+void RetargetingKernel::computeIntensitiesScalar(const size_t firstGroup, const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    for(size_t group=firstGroup; group<numberOfGroups; group++)
+    {
+        intensities[group] = computeActuationIntensity(groupNorms[group]+offsets[group], minThresholds[group], maxThresholds[group]);
+    }
+}
+
+#ifdef WEIGHT_RETARGETING_KERNEL_X86
+
+WEIGHT_RETARGETING_TARGET_SSE2
+void RetargetingKernel::computeNormsSSE2()
+{
+    const size_t numberOfBlocks = blockOffsets.size()-1;
+    for(size_t block=0; block<numberOfBlocks; block++)
+    {
+        __m128d sum = _mm_setzero_pd();
+        for(int row=blockOffsets[block]; row<blockOffsets[block+1]; row++)
+        {
+            const int* indexes = &blockIndexes[row*2];
+            sum = _mm_add_pd(sum, _mm_set_pd(squares[indexes[1]], squares[indexes[0]]));
+        }
+        _mm_storeu_pd(&norms[block*2], _mm_sqrt_pd(sum));
+    }
+}
+
+WEIGHT_RETARGETING_TARGET_SSE2
+void RetargetingKernel::computeIntensitiesSSE2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    // offsets, normalization, clamp and truncation
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d maxIntensity = _mm_set1_pd(WEIGHT_RETARGETING_MAX_INTENSITY);
+    size_t group = 0;
+    for(; group+2<=numberOfGroups; group+=2)
+    {
+        const __m128d norm = _mm_add_pd(_mm_loadu_pd(groupNorms+group), _mm_loadu_pd(offsets+group));
+        const __m128d minThreshold = _mm_loadu_pd(minThresholds+group);
+        const __m128d normalizedValue = _mm_div_pd(_mm_sub_pd(norm, minThreshold), _mm_sub_pd(_mm_loadu_pd(maxThresholds+group), minThreshold));
+        const __m128d positive = _mm_cmpgt_pd(normalizedValue, zero);
+        const __m128d scaledValue = _mm_mul_pd(_mm_min_pd(normalizedValue, one), maxIntensity);
+        const __m128d truncatedValue = _mm_cvtepi32_pd(_mm_cvttpd_epi32(scaledValue));
+        _mm_storeu_pd(intensities+group, _mm_and_pd(truncatedValue, positive));
+    }
+    computeIntensitiesScalar(group, groupNorms, offsets, minThresholds, maxThresholds, intensities);
+}
+
+WEIGHT_RETARGETING_TARGET_AVX2
+void RetargetingKernel::computeNormsAVX2()
+{
+    const size_t numberOfBlocks = blockOffsets.size()-1;
+    for(size_t block=0; block<numberOfBlocks; block++)
+    {
+        __m256d sum = _mm256_setzero_pd();
+        for(int row=blockOffsets[block]; row<blockOffsets[block+1]; row++)
+        {
+            const __m128i indexes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blockIndexes[row*4]));
+            sum = _mm256_add_pd(sum, _mm256_i32gather_pd(squares.data(), indexes, 8));
+        }
+        _mm256_storeu_pd(&norms[block*4], _mm256_sqrt_pd(sum));
+    }
+}
+
+WEIGHT_RETARGETING_TARGET_AVX2
+void RetargetingKernel::computeIntensitiesAVX2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    // offsets, normalization, clamp and truncation
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d maxIntensity = _mm256_set1_pd(WEIGHT_RETARGETING_MAX_INTENSITY);
+    size_t group = 0;
+    for(; group+4<=numberOfGroups; group+=4)
+    {
+        const __m256d norm = _mm256_add_pd(_mm256_loadu_pd(groupNorms+group), _mm256_loadu_pd(offsets+group));
+        const __m256d minThreshold = _mm256_loadu_pd(minThresholds+group);
+        const __m256d normalizedValue = _mm256_div_pd(_mm256_sub_pd(norm, minThreshold), _mm256_sub_pd(_mm256_loadu_pd(maxThresholds+group), minThreshold));
+        const __m256d positive = _mm256_cmp_pd(normalizedValue, zero, _CMP_GT_OQ);
+        const __m256d scaledValue = _mm256_mul_pd(_mm256_min_pd(normalizedValue, one), maxIntensity);
+        const __m256d truncatedValue = _mm256_cvtepi32_pd(_mm256_cvttpd_epi32(scaledValue));
+        _mm256_storeu_pd(intensities+group, _mm256_and_pd(truncatedValue, positive));
+    }
+    computeIntensitiesScalar(group, groupNorms, offsets, minThresholds, maxThresholds, intensities);
+}
+
+#else
+
+void RetargetingKernel::computeNormsSSE2()
+{
+    computeNormsScalar();
+}
+
+void RetargetingKernel::computeIntensitiesSSE2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    computeIntensitiesScalar(0, groupNorms, offsets, minThresholds, maxThresholds, intensities);
+}
+
+void RetargetingKernel::computeNormsAVX2()
+{
+    computeNormsScalar();
+}
+
+void RetargetingKernel::computeIntensitiesAVX2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities)
+{
+    computeIntensitiesScalar(0, groupNorms, offsets, minThresholds, maxThresholds, intensities);
+}
+
+#endif
@@ -0,0 +1,73 @@
+#include "TaskPool.h"
+
+TaskPool::~TaskPool()
+{
+    stop();
+}
+
+void TaskPool::start(const size_t numberOfThreads)
+{
+    stop();
+    stopping = false;
+    for(size_t i=1; i<numberOfThreads; i++)
+        workers.emplace_back(&TaskPool::runWorker, this);
+}
+
+void TaskPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(poolMutex);
+        stopping = true;
+    }
+    jobStarted.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+}
+
+void TaskPool::run(Job& job, const size_t numberOfTasks)
+{
+    // start a new generation, taken by the workers and by this thread
+    std::unique_lock<std::mutex> lock(poolMutex);
+    currentJob = &job;
+    currentTasks = numberOfTasks;
+    nextTask = 0;
+    completedTasks = 0;
+    generation++;
+    jobStarted.notify_all();
+
+    runTasks(lock);
+    jobCompleted.wait(lock, [&]{ return completedTasks==currentTasks; });
+    currentJob = nullptr;
+}
+
+void TaskPool::runTasks(std::unique_lock<std::mutex>& lock)
+{
+    while(nextTask<currentTasks)
+    {
+        const size_t task = nextTask++;
+        Job& job = *currentJob;
+
+        lock.unlock();
+        job.runTask(task);
+        lock.lock();
+
+        if(++completedTasks==currentTasks)
+            jobCompleted.notify_one();
+    }
+}
+
+void TaskPool::runWorker()
+{
+    std::unique_lock<std::mutex> lock(poolMutex);
+    size_t lastGeneration = generation;
+    while(true)
+    {
+        jobStarted.wait(lock, [&]{ return stopping || generation!=lastGeneration; });
+        if(stopping)
+            return;
+
+        lastGeneration = generation;
+        runTasks(lock);
+    }
+}
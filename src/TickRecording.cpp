@@ -0,0 +1,173 @@
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define WEIGHT_RETARGETING_RECORDING_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TickRecording.h"
+
+static_assert(sizeof(TickRecordingHeader)%sizeof(double)==0, "The records must be aligned to double");
+
+constexpr char TickRecordingHeader::MAGIC[8];
+
+TickRecorder::~TickRecorder()
+{
+    close();
+}
+
+bool TickRecorder::open(const std::string& path, const TickRecordingHeader::Source source, const size_t numberOfValues, const size_t numberOfVelocities)
+{
+    close();
+
+    std::memcpy(header.magic, TickRecordingHeader::MAGIC, sizeof(header.magic));
+    header.version = TickRecordingHeader::VERSION;
+    header.source = source;
+    header.numberOfValues = static_cast<uint32_t>(numberOfValues);
+    header.numberOfVelocities = static_cast<uint32_t>(numberOfVelocities);
+
+    file = std::fopen(path.c_str(), "wb");
+    if(file==nullptr)
+        return false;
+
+    if(std::fwrite(&header, sizeof(header), 1, file)!=1)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TickRecorder::write(const double time, const double* values, const double* velocities)
+{
+    if(file==nullptr)
+        return false;
+
+    bool result = std::fwrite(&time, sizeof(double), 1, file)==1;
+    result = result && std::fwrite(values, sizeof(double), header.numberOfValues, file)==header.numberOfValues;
+    if(velocities!=nullptr)
+    {
+        result = result && std::fwrite(velocities, sizeof(double), header.numberOfVelocities, file)==header.numberOfVelocities;
+    }
+    else
+    {
+        const double zero = 0.0;
+        for(uint32_t i=0; i<header.numberOfVelocities; i++)
+            result = result && std::fwrite(&zero, sizeof(double), 1, file)==1;
+    }
+    return result;
+}
+
+void TickRecorder::close()
+{
+    if(file==nullptr)
+        return;
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+TickRecording::~TickRecording()
+{
+    release();
+}
+
+bool TickRecording::open(const std::string& path, std::string& error)
+{
+    release();
+
+#ifdef WEIGHT_RETARGETING_RECORDING_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd<0)
+    {
+        error = "unable to open "+path;
+        return false;
+    }
+    struct stat fileStat;
+    if(fstat(fd, &fileStat)!=0 || fileStat.st_size<static_cast<off_t>(sizeof(TickRecordingHeader)))
+    {
+        ::close(fd);
+        error = path+" is too short to be a recording";
+        return false;
+    }
+    dataSize = static_cast<size_t>(fileStat.st_size);
+    void* address = mmap(nullptr, dataSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(address==MAP_FAILED)
+    {
+        dataSize = 0;
+        error = "unable to map "+path;
+        return false;
+    }
+    data = static_cast<const unsigned char*>(address);
+    mapped = true;
+#else
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if(file==nullptr)
+    {
+        error = "unable to open "+path;
+        return false;
+    }
+    std::fseek(file, 0, SEEK_END);
+    long fileSize = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    if(fileSize<static_cast<long>(sizeof(TickRecordingHeader)))
+    {
+        std::fclose(file);
+        error = path+" is too short to be a recording";
+        return false;
+    }
+    dataSize = static_cast<size_t>(fileSize);
+    loadedData.resize((dataSize+sizeof(double)-1)/sizeof(double));
+    bool readResult = std::fread(loadedData.data(), 1, dataSize, file)==dataSize;
+    std::fclose(file);
+    if(!readResult)
+    {
+        release();
+        error = "unable to read "+path;
+        return false;
+    }
+    data = reinterpret_cast<const unsigned char*>(loadedData.data());
+#endif
+
+    const TickRecordingHeader& header = getHeader();
+    if(std::memcmp(header.magic, TickRecordingHeader::MAGIC, sizeof(header.magic))!=0)
+    {
+        release();
+        error = path+" is not a tick recording";
+        return false;
+    }
+    if(header.version!=TickRecordingHeader::VERSION)
+    {
+        release();
+        error = path+" has an unsupported version";
+        return false;
+    }
+    if(header.source!=TickRecordingHeader::Source::Retargeting && header.source!=TickRecordingHeader::Source::Display)
+    {
+        release();
+        error = path+" has an unknown source";
+        return false;
+    }
+
+    // a truncated last record is ignored
+    numberOfTicks = (dataSize-sizeof(TickRecordingHeader))/header.getRecordSize();
+    return true;
+}
+
+void TickRecording::release()
+{
+#ifdef WEIGHT_RETARGETING_RECORDING_MMAP
+    if(mapped)
+        munmap(const_cast<unsigned char*>(data), dataSize);
+#endif
+    mapped = false;
+    data = nullptr;
+    dataSize = 0;
+    numberOfTicks = 0;
+    loadedData.clear();
+}
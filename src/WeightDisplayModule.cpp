@@ -1,51 +1,75 @@
-#include <algorithm>
-#include <unordered_map>
-#include <memory>
 #include <iomanip>
+#include <limits>
+#include <mutex>
 
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/LogStream.h>
 #include <yarp/os/BufferedPort.h>
-#include <yarp/sig/Vector.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
 
 #include <yarp/dev/PolyDriver.h>
 #include <yarp/dev/IEncodersTimed.h>
 
+#include <thrift/WeightDisplayService.h>
+
+#include "TickRecording.h"
+#include "WeightRetargetingCore.h"
+#include "WrenchAcquisition.h"
 #include "WeightRetargetingLogComponent.h"
 
-class WeightDisplayModule : public yarp::os::RFModule
+class WeightDisplayModule : public yarp::os::RFModule, WeightDisplayService, WrenchAcquisition::Listener
 {
 public:
 
     const std::string LOG_PREFIX = "DisplayModule"; 
 
-    const double GRAVITY_ACCELERATION = 9.81;
     const int FRACTIONAL_DIGITS = 1; // Number of digits of the weight's fractional part  
 
     double period = 0.02; //Default 50Hz
 
-    double minWeight = 0.0; // minimum weight to be displayed
+    // input and orientation ports, shared with the weight retargeted by the WeightRetargetingModule
+    WrenchAcquisition wrenchAcquisition;
+    std::vector<const double*> wrenches;
+    std::vector<double> wrenchTimes; // timestamps of the newest wrenches, the tare collects only the new ones
+
+    // update the weight when a wrench arrives instead of every period
+    bool eventDriven = false;
+
+    // wrenches without their offsets
+    std::vector<WeightDisplayCore::Wrench> compensatedWrenches;
+
+    // RPC
+    yarp::os::Port rpcPort;
 
-    // input port
-    std::vector<std::string> inputPortNames;
-    std::vector<std::unique_ptr<yarp::os::BufferedPort<yarp::sig::Vector>>> inputPorts;
+    // rotate the wrenches in the gravity frame with the orientations of the end effectors, instead of assuming their z-axis vertical
+    std::vector<const double*> rotations;
+    std::vector<WeightDisplayCore::Wrench> rotatedWrenches;
 
     // output port
     std::string portPrefix = "/WeightDisplay";
     std::string outPortName;
     yarp::os::BufferedPort<yarp::os::Bottle> outPort;
 
+    // weight in kilograms published at each update, timestamped with its wrenches, read by the WeightRetargetingModule
+    // instead of reading the wrenches again
+    yarp::os::BufferedPort<yarp::sig::Vector> weightPort;
+    yarp::os::Stamp weightStamp;
+
+    // weight computation logic
+    WeightDisplayCore core;
+
+    // Recording of the input wrenches, used for the offline replay
+    TickRecorder recorder;
+    std::vector<double> recordedWrenches;
+
     //use velocity info
     struct VelocityHelper
     {
-        bool useVelocity = false;
         std::string robotName;
-        double maxVelocity;
         std::vector<std::string> remoteBoards;
-        std::vector<std::string> jointAxes;
         yarp::dev::PolyDriver remappedControlBoard;
-        std::unordered_map<std::string, std::vector<int>> portToJoints;
         yarp::dev::IEncodersTimed* iEncodersTimed{nullptr};
     };
 
@@ -58,50 +82,88 @@ public:
     }
 
     bool updateModule() override
+    {
+        // in the event-driven mode the weight is updated by the callbacks of the input ports
+        if(eventDriven)
+            return true;
+
+        // store the new wrenches, the ports without new data keep the previous ones
+        double time = yarp::os::Time::now();
+        std::lock_guard<std::mutex> lock(wrenchAcquisition.mutex);
+        wrenchAcquisition.read(time);
+
+        updateWeight(time);
+
+        return true;
+    }
+
+    /**
+     * @brief Called in the event-driven mode when a wrench arrives on an input port, once it has been stored
+     * 
+     * @param time the arrival time of the wrench
+     */
+    void onWrench(const double time) override
+    {
+        updateWeight(time);
+    }
+
+    /**
+     * @brief Compute and publish the weight with the latest wrenches, the mutex of the acquisition must be locked.
+     * The wrenches older than the staleness window are not available.
+     * 
+     * @param time the current time
+     */
+    void updateWeight(const double time)
     {
         bool getVelocityResult = false;
-        if(velocityHelper.useVelocity)
+        if(core.useVelocity)
         {
             getVelocityResult = velocityHelper.iEncodersTimed->getEncoderSpeeds(jointVelBuffer.data());
         }
 
-        if(velocityHelper.useVelocity && !getVelocityResult)
+        if(core.useVelocity && !getVelocityResult)
         {
             //TODO use timeout
             //skip cycle
-            return true;
+            return;
         }
 
-        // sum z-axis forces
-        double zForce = 0.0;
-        for(auto const & port : inputPorts)
+        // take the latest wrenches, interpolated at a common timestamp with the time alignment
+        double measurementTime = wrenchAcquisition.getWrenches(time, wrenches);
+
+        // collect the new samples of the tare in progress, then remove the offsets without locking
+        wrenchAcquisition.getWrenchTimes(wrenchTimes);
+        core.updateTare(wrenches, wrenchTimes, time);
+        double minWeight = core.removeOffsets(wrenches, compensatedWrenches);
+
+        // express the wrenches in the gravity frame, the wrenches without a recent orientation are not available
+        if(wrenchAcquisition.useOrientation())
         {
-            // check on the velocity
-            bool readFromPort = true;
-            if(velocityHelper.useVelocity)
-            {
-                auto const& jointsIndices = velocityHelper.portToJoints[port->getName()];  
-                for(int i=0; i<jointsIndices.size(); i++)
-                {
-                    if(jointVelBuffer[jointsIndices[i]]>velocityHelper.maxVelocity)
-                    {
-                        readFromPort = false;
-                    }
-                }
-            }
+            wrenchAcquisition.getRotations(time, rotations);
+            WeightDisplayCore::rotateWrenches(rotations, wrenches, rotatedWrenches);
+        }
 
-            // add the force if the velocity check is passed
-            if(readFromPort)
-            {
-                yarp::sig::Vector* wrench = port->read(false);
-                if(wrench!=nullptr && (*wrench)[2]<0)
-                    zForce += -(*wrench)[2];
-            }
-            
+        if(recorder.isOpen())
+        {
+            for(size_t i=0; i<wrenches.size(); i++)
+                copyRecordedWrench(i, wrenches[i]);
+        }
+
+        if(recorder.isOpen() && !recorder.write(time, recordedWrenches.data(), jointVelBuffer.data()))
+        {
+            yCIWarningThrottle(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX, 5.0) << "Unable to record the inputs";
         }
 
         // calculate weight
-        double weight = zForce/GRAVITY_ACCELERATION;
+        double weight = core.computeWeight(wrenches, jointVelBuffer);
+
+        // publish the weight for the retargeting, its groups apply their own thresholds
+        weightStamp.update(measurementTime);
+        yarp::sig::Vector& weightMessage = weightPort.prepare();
+        weightMessage.resize(1);
+        weightMessage[0] = weight;
+        weightPort.setEnvelope(weightStamp);
+        weightPort.write(false);
 
         // write to port
         if(weight>=minWeight)
@@ -115,42 +177,33 @@ public:
             weightLabelMessage.addString(stream.str());
             outPort.write(false);
         }
-
-        return true;
     }
 
-    bool readVelocityInfoGroup(yarp::os::ResourceFinder &rf)
+    /**
+     * @brief Copy an input wrench in the record buffer, the values not available are recorded as NaN
+     * 
+     * @param input the index of the input
+     * @param wrench the wrench of the input, nullptr if not available
+     */
+    void copyRecordedWrench(const size_t input, const double* wrench)
     {
-        yarp::os::Bottle velocityUtilsGroup = rf.findGroup("VELOCITY_UTILS");
-        if(velocityUtilsGroup.isNull())
+        for(size_t j=0; j<TickRecordingHeader::WRENCH_SIZE; j++)
         {
-            // use default
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Group VELOCITY_UTILS not found, velocity information will not be used";
-            return true; 
+            double value = std::numeric_limits<double>::quiet_NaN();
+            if(wrench!=nullptr)
+                value = wrench[j];
+            recordedWrenches[input*TickRecordingHeader::WRENCH_SIZE+j] = value;
         }
+    }
 
-        // read use_velocity 
-        if(!velocityUtilsGroup.check("use_velocity"))
-        {
-            // use default
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter use_velocity. Using default value:"<<velocityHelper.useVelocity;
-            return true;
-        }
-        velocityHelper.useVelocity = velocityUtilsGroup.find("use_velocity").asBool();
-        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter use_velocity is:"<<velocityHelper.useVelocity;
-
-        if(!velocityHelper.useVelocity)
+    bool readVelocityInfoGroup(yarp::os::ResourceFinder &rf)
+    {
+        // the velocity check parameters are read by the core
+        if(!core.useVelocity)
         {
             return true;
         }
-
-        // read max_velocity
-        if(!velocityUtilsGroup.check("max_velocity"))
-        {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter max_velocity when use_velocity is enabled";
-            return false;
-        }
-        velocityHelper.maxVelocity = velocityUtilsGroup.find("max_velocity").asFloat64();
+        yarp::os::Bottle velocityUtilsGroup = rf.findGroup("VELOCITY_UTILS");
 
         // read robot
         if(!velocityUtilsGroup.check("robot"))
@@ -177,7 +230,7 @@ public:
             yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter remote_boards cannot be an empty list!";
             return false;
         }
-        for(int i=0;i<remoteBoardsBottle->size();i++)
+        for(size_t i=0;i<remoteBoardsBottle->size();i++)
         {
             std::string remoteBoard = remoteBoardsBottle->get(i).asString();\
             if(remoteBoard[0]!='/') remoteBoard = "/" + remoteBoard; 
@@ -185,41 +238,6 @@ public:
             velocityHelper.remoteBoards.push_back(remoteBoard);
         }
 
-        // read joints_info
-        if(!velocityUtilsGroup.check("joints_info"))
-        {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter remote_boards when joints_info is enabled";
-            return false;
-        }
-        yarp::os::Bottle* jointsInfoBottle = velocityUtilsGroup.find("joints_info").asList();
-        if(jointsInfoBottle->size()==0)
-        {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter joints_info cannot be an empty list!";
-            return false;
-        }
-        for(int i=0;i<jointsInfoBottle->size();i++)
-        {
-            yarp::os::Bottle* infoBottle = jointsInfoBottle->get(i).asList(); 
-            if(infoBottle->size()<2)
-            {
-                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Bad joints_info format!";
-                return false;
-            }
-            // read port name
-            std::string portName = portPrefix+"/"+infoBottle->get(0).asString();
-
-
-            // read joint axes
-            std::vector<int> jointsIndices = {};
-            for(int j=1; j<infoBottle->size(); j++)
-            {
-                jointsIndices.push_back(velocityHelper.jointAxes.size());
-                velocityHelper.jointAxes.push_back(infoBottle->get(j).asString());
-            }
-
-            velocityHelper.portToJoints[portName] = jointsIndices;
-        }
-
         return true;
     }
 
@@ -245,34 +263,18 @@ public:
             yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter port_prefix:" << portPrefix;
         }
 
-        // read input port names
-        yarp::os::Bottle* inputPortNamesBottle = rf.find("input_port_names").asList();
-        if(inputPortNamesBottle == nullptr)
-        {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter input_port_names!";
+        // read the input names and the velocity check parameters
+        if(!core.configure(rf))
             return false;
-        }
-        else if(inputPortNamesBottle->size()==0)
-        {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter input_port_names is empty!";
-            return false;
-        }
-        
-        for(int i=0; i<inputPortNamesBottle->size(); i++)
-        {
-            std::string portName = inputPortNamesBottle->get(i).asString();
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found input port name:"<<portName;
-            inputPortNames.push_back(portPrefix+"/"+portName+":i");
-        }
 
-        // read min_weight
-        if(!rf.check("min_weight"))
+        // read event_driven
+        if(!rf.check("event_driven"))
         {
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter min_weight, using default value:"<<minWeight;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter event_driven, using default value:"<<eventDriven;
         } else
         {
-            minWeight = rf.find("min_weight").asFloat64();
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter min_weight:" << minWeight;
+            eventDriven = rf.find("event_driven").asBool();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter event_driven:" << eventDriven;
         }
 
         // read velocity info
@@ -288,18 +290,16 @@ public:
             return false;
         }
 
-        // open input ports
-        int inputPortIdx = 0;
-        inputPorts.reserve(inputPortNames.size());
-        for(const std::string& portName : inputPortNames)
+        // read the parameters of the acquisition of the wrenches and open the input and orientation ports
+        if(!wrenchAcquisition.configure(rf, core.inputNames, portPrefix))
         {
-            inputPorts.push_back(std::make_unique<yarp::os::BufferedPort<yarp::sig::Vector>>());
-            if(!inputPorts[inputPortIdx++]->open(portName))
-            {
-                yCError(WEIGHT_RETARGETING_LOG_COMPONENT)<<"Unable to open input port:"<< portName;
-                return false;
-            }
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to configure the acquisition of the wrenches";
+            return false;
         }
+        const size_t numberOfInputs = wrenchAcquisition.getNumberOfInputs();
+        rotations.assign(numberOfInputs, nullptr);
+        rotatedWrenches.resize(numberOfInputs);
+        compensatedWrenches.resize(numberOfInputs);
 
         // open output port
         outPortName = portPrefix+"/out:o";
@@ -309,11 +309,21 @@ public:
             return false;
         }
 
+        std::string weightPortName = portPrefix+"/weight:o";
+        if(!weightPort.open(weightPortName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open output port:"<< weightPortName;
+            return false;
+        }
+
+        wrenches.resize(numberOfInputs, nullptr);
+        wrenchTimes.resize(numberOfInputs);
+
         // manage use velocity
-        if(velocityHelper.useVelocity)
+        if(core.useVelocity)
         {
             // set the size of the data buffer
-            jointVelBuffer.resize(velocityHelper.jointAxes.size());
+            jointVelBuffer.resize(core.jointAxes.size());
 
             // configure the remapper
             yarp::os::Property propRemapper;
@@ -321,7 +331,7 @@ public:
             // axes names
             propRemapper.addGroup("axesNames");
             yarp::os::Bottle& axesNamesBottle = propRemapper.findGroup("axesNames").addList();
-            for(std::string& s : velocityHelper.jointAxes) axesNamesBottle.addString(s);
+            for(std::string& s : core.jointAxes) axesNamesBottle.addString(s);
             // remote control boards names
             propRemapper.addGroup("remoteControlBoards");
             yarp::os::Bottle& remoteControlBoardsNamesBottle = propRemapper.findGroup("remoteControlBoards").addList();
@@ -344,6 +354,39 @@ public:
             }
         }
 
+        // read record_file param
+        if(!rf.check("record_file"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter record_file, the inputs will not be recorded";
+        } else
+        {
+            std::string recordFile = rf.find("record_file").asString();
+            recordedWrenches.resize(numberOfInputs*TickRecordingHeader::WRENCH_SIZE);
+            if(!recorder.open(recordFile, TickRecordingHeader::Source::Display, recordedWrenches.size(), jointVelBuffer.size()))
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the record file" << recordFile;
+                return false;
+            }
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Recording the inputs in" << recordFile;
+        }
+
+        // open the RPC port
+        std::string rpcPortName = portPrefix+"/rpc:i";
+        if(!rpcPort.open(rpcPortName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open RPC port:"<< rpcPortName;
+            return false;
+        }
+        if(!this->yarp().attachAsServer(rpcPort))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to attach" << rpcPortName << "to the RPC service";
+            return false;
+        }
+
+        // start the callbacks of the input ports once everything else is configured
+        if(eventDriven)
+            wrenchAcquisition.useCallbacks(*this);
+
         yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT,  LOG_PREFIX) << "Module started successfully!";
 
         return true;
@@ -351,22 +394,58 @@ public:
 
     bool close() override
     {
-        // close input ports
-        for(auto & port : inputPorts)
-            port->close();
+        // close input and orientation ports, stopping their callbacks
+        wrenchAcquisition.close();
 
         // close the control board remapper
-        if(velocityHelper.useVelocity)
+        if(core.useVelocity)
         {
             velocityHelper.remappedControlBoard.close();
         }
 
-        // close output port
+        // close output ports
         outPort.close();
+        weightPort.close();
+
+        rpcPort.close();
+
+        recorder.close();
         
         return true;
     }
 
+    bool tare(const std::string& input) override
+    {
+        if(!core.requestTare(input))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to tare" << input << ": unknown input or tare already in progress";
+            return false;
+        }
+        return true;
+    }
+
+    TareStatus getTareStatus() override
+    {
+        TareStatus status;
+        const int input = core.tareRequestedInput;
+        status.state = WeightDisplayCore::tareStateToString(core.tareState);
+        status.input = input<0 ? "all" : core.inputNames[input];
+        status.collectedSamples = core.tareCollectedSamples;
+        status.maxSamples = core.tareSamples;
+        status.result = WeightDisplayCore::tareResultToString(core.tareResult);
+        return status;
+    }
+
+    bool clearTare(const std::string& input) override
+    {
+        return core.clearTare(input);
+    }
+
+    bool setMinWeight(const double value) override
+    {
+        return core.setMinWeight(value);
+    }
+
 };
 
 int main(int argc, char * argv[])
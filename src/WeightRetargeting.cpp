@@ -1,360 +1,548 @@
 #include <algorithm>
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <mutex>
-#include <cmath>
 
 #include <yarp/os/Network.h>
 #include <yarp/os/RFModule.h>
 #include <yarp/os/LogStream.h>
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+#include <yarp/os/Time.h>
+#include <yarp/sig/Vector.h>
 
 #include <yarp/dev/PolyDriver.h>
-#include <yarp/dev/ITorqueControl.h>
-#include <yarp/dev/ICurrentControl.h>
-#include <yarp/dev/IEncodersTimed.h>
 
 #include <thrift/WeightRetargetingService.h>
 #include <thrift/WearableActuatorCommand.h>
 
+#include "AllocationCounter.h"
+#include "BatchedActuationCommand.h"
+#include "JointAcquisitionThread.h"
+#include "LatencyStats.h"
+#include "ParallelBoardReader.h"
+#include "RetargetingLayouts.h"
+#include "TaskPool.h"
+#include "TickRecording.h"
+#include "WeightRetargetingCore.h"
 #include "WeightRetargetingLogComponent.h"
+#include "WrenchAcquisition.h"
 
-#define WEIGHT_RETARGETING_MAX_INTENSITY 127
-
-class WeightRetargetingModule : public yarp::os::RFModule, WeightRetargetingService
+/**
+ * @brief Retargeting of a robot to a suit, with its own control boards, ports and RPC service.
+ * Several instances can be hosted by the same WeightRetargetingModule, sharing its scheduler and acquisition threads.
+ */
+class WeightRetargetingInstance : public WeightRetargetingService
 {
 public:
 
-    struct ActuatorGroupInfo
+    using RetargetedValue = JointAcquisition::RetargetedValue;
+
+    enum class OutputMode
     {
-        std::vector<int> jointIndexes;
-        double minThreshold;
-        double maxThreshold;
-        double offset;
-        std::vector<std::string> actuators;
+        PerActuator,
+        Batched,
+        Vector,
+        Invalid
     };
 
-    enum class RetargetedValue
+    static OutputMode outputModefromString(const std::string& name)
     {
-        JointTorque,
-        MotorCurrent,
+        if(name=="per_actuator")
+            return OutputMode::PerActuator;
+        if(name=="batched")
+            return OutputMode::Batched;
+        if(name=="vector")
+            return OutputMode::Vector;
+
+        return OutputMode::Invalid;
+    }
+
+    enum class AcquisitionMode
+    {
+        Remapper,
+        Parallel,
         Invalid
     };
 
-    static RetargetedValue retargetedValuefromString(const std::string& name)
+    static AcquisitionMode acquisitionModefromString(const std::string& name)
     {
-        if(name=="joint_torque")
-            return RetargetedValue::JointTorque;
-        if(name=="motor_current")
-            return RetargetedValue::MotorCurrent;
-        
-        return RetargetedValue::Invalid;
+        if(name=="remapper")
+            return AcquisitionMode::Remapper;
+        if(name=="parallel")
+            return AcquisitionMode::Parallel;
+
+        return AcquisitionMode::Invalid;
     }
 
     const std::string LOG_PREFIX = "HapticModule"; 
 
-    const std::string IFEEL_SUIT_ACTUATOR_PREFIX = "iFeelSuit::haptic::Node#";
-    
-    // Number of configuration parameters defining an actuator group
-    const int CONFIG_GROUP_SIZE = 5;
+    /**
+     * @brief Retargeting logic with the buffers sized on its actuator groups, replaced as a whole by reloadConfig
+     */
+    struct Retargeting
+    {
+        WeightRetargetingCore core;
+        std::vector<WeightRetargetingCore::ActuationCommand> actuationCommands;
+        std::vector<double> actuatorIntensities; // last intensity of each actuator, used by the vector output
+        BatchedActuationCommand::ActuatorNames actuatorNames; // names of the actuators, shared with the batched messages
+    };
 
-    double period = 0.02; //Default 50Hz
+    std::string robotName;
+    std::string configFile; // read again by reloadConfig
+    std::string configSection; // group of the configuration file of the instance, empty if it is the whole file
+    std::string portPrefix; // prefix of the ports of the instance
 
-    std::mutex mutex;
+    /**
+     * @brief Control boards of the retargeted joints, replaced as a whole by reloadConfig when the joints change
+     */
+    struct ControlBoard
+    {
+        yarp::dev::PolyDriver remapper; // used in remapper acquisition mode
+        ParallelBoardReader boardReader; // used in parallel acquisition mode
+    };
+
+    // Acquisition from a single remapper of all of the boards, or from each board concurrently
+    AcquisitionMode acquisitionMode = AcquisitionMode::Remapper;
+    std::unique_ptr<ControlBoard> controlBoard;
+    unsigned int controlBoardGeneration = 0; // number of control boards opened, the ones opened by reloadConfig use different local ports
+    bool acquisitionLost = false; // set if reloadConfig could not restore the acquisition of the current configuration
 
-    yarp::dev::PolyDriver remappedControlBoard;
+    // Retargeting logic, swapped by reloadConfig at the boundary of a control cycle:
+    // the cycle runs holding the mutex and it is skipped, instead of waiting, while a swap is in progress
+    std::unique_ptr<Retargeting> retargeting;
+    std::mutex retargetingMutex;
 
     // RetargetedValue
     RetargetedValue retargetedValue;
-    yarp::dev::ITorqueControl* iTorqueControl{ nullptr };
-    yarp::dev::ICurrentControl* iCurrentControl{ nullptr };
-    
-    // Velocity check parameters
-    bool useVelocities = false;
-    yarp::dev::IEncodersTimed* iEncodersTimed{ nullptr };
-    std::vector<double> velocities;
-    double maxJointVelocity = 0.35;
 
     std::vector<std::string> remoteControlBoards;
-    std::vector<std::string> jointNames;
-    std::unordered_map<std::string,ActuatorGroupInfo> actuatorGroupMap; 
 
-    // Data acquisition variables
-    std::vector<double> interfaceValues;
+    // Data acquisition variables, the thread and the pool of threads reading the boards are shared by the instances of the module
+    JointAcquisitionThread* acquisitionThread{nullptr};
+    TaskPool* acquisitionPool{nullptr};
+    const WeightAcquisition* weightAcquisition{nullptr}; // weight held by the end effectors, nullptr if it is not acquired by the module
+    JointAcquisition acquisition;
     const std::chrono::milliseconds ACQUISITION_TIMEOUT = std::chrono::milliseconds(5000);
     std::chrono::time_point<std::chrono::system_clock> lastAcquisition;
 
     // Haptic command
     yarp::os::BufferedPort<wearable::msg::WearableActuatorCommand> actuatorCommandPort;
-    double minIntensity = 0.0;
+    OutputMode outputMode = OutputMode::PerActuator;
+    // Batched haptic commands, one message per cycle in the form ((<actuator_name> <intensity>)+)
+    yarp::os::BufferedPort<BatchedActuationCommand> batchedCommandPort;
+    // Intensities of all of the actuators in the order given by getActuatorOrder, one message per cycle
+    yarp::os::BufferedPort<yarp::sig::Vector> vectorCommandPort;
+
+    // Delta output statistics
+    const double SAVED_COMMANDS_RATE_WINDOW = 1.0; // [s]
+    double savedCommandsWindowStart = 0.0;
+    size_t savedCommandsWindowCount = 0; // suppressed commands at the start of the window
+    std::atomic<double> savedCommandsRate{0.0};
+
+    // Latency statistics, published periodically in the form ((<stage> <count> <p50> <p99> <p999> <max>)+) in milliseconds
+    LatencyStats latencyStats;
+    double latencyStatsPeriod = 1.0; // [s]
+    double lastLatencyStatsTime = 0.0;
+    yarp::os::BufferedPort<yarp::os::Bottle> latencyStatsPort;
+
+    // Recording of the acquired samples, used for the offline replay
+    TickRecorder recorder;
 
     // RPC
     yarp::os::Port rpcPort;
 
-    double getPeriod() override
-    {
-        return period; //50Hz
-    }
-
     /**
-     * @brief Get the square norms of the retargeted interface of an actuator group
+     * @brief Update the rate of the commands not sent thanks to the delta output
      * 
-     * @param groupInfo the actuators group
-     * @return double the norm of the read measurements
+     * @param time the current time in seconds
      */
-    double getNorm(const ActuatorGroupInfo& groupInfo)
+    void updateSavedCommandsRate(const double time)
     {
-        double sum = 0;
-        for(const int &index : groupInfo.jointIndexes)
-        {
-            sum += interfaceValues[index] * interfaceValues[index];
-        }
-        return std::sqrt(sum);
+        double elapsedTime = time - savedCommandsWindowStart;
+        if(elapsedTime<SAVED_COMMANDS_RATE_WINDOW)
+            return;
+
+        const WeightRetargetingCore& core = retargeting->core;
+        savedCommandsRate = (core.suppressedCommands - savedCommandsWindowCount)/elapsedTime;
+        savedCommandsWindowStart = time;
+        savedCommandsWindowCount = core.suppressedCommands;
     }
 
-    double computeActuationIntensity(const double measuredValue, const double minThreshold, const double maxThreshold)
+    /**
+     * @brief Get the time elapsed from a starting point in seconds
+     * 
+     * @param start the starting point
+     * @return double the elapsed time
+     */
+    static double getElapsedTime(const std::chrono::steady_clock::time_point& start)
     {
-        double actuationIntensity = 0.0;
-        double normalizedValue = (measuredValue - minThreshold) / (maxThreshold - minThreshold);
-        if(normalizedValue>0)
-        {
-            if(normalizedValue>1.0) normalizedValue = 1.0;
-
-            //TODO check if it's better to use steps
-            actuationIntensity = (int)(normalizedValue*WEIGHT_RETARGETING_MAX_INTENSITY);
-        }
-        return actuationIntensity;
+        return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
     }
 
     /**
-     * @brief Check the max velocity constraint for an actuator group
+     * @brief Generates and sends the actuation commands for all of the configured groups
      * 
-     * @param groupInfo the group to check
-     * @return true if none of the related joints' velocity is above threshold
-     * @return false otherwise
+     * @param sample the sample of the joints data
+     * @param time the current time in seconds
      */
-    bool checkGroupVelocity(const ActuatorGroupInfo& groupInfo)
+    void generateGroupsActuation(const JointAcquisition::JointSample& sample, const double time)
     {
-        for(const int &index : groupInfo.jointIndexes)
+        WeightRetargetingCore& core = retargeting->core;
+        std::vector<WeightRetargetingCore::ActuationCommand>& actuationCommands = retargeting->actuationCommands;
+        std::vector<double>& actuatorIntensities = retargeting->actuatorIntensities;
+
+        auto stageStart = std::chrono::steady_clock::now();
+        core.generateGroupsActuation(sample.interfaceValues, sample.velocities, time, sample.measurementTime, actuationCommands);
+        latencyStats.get(LatencyStats::Stage::Compute).recordSeconds(getElapsedTime(stageStart));
+        if(core.predictorType!=GroupPredictor::Type::None)
+            latencyStats.get(LatencyStats::Stage::PredictionLead).recordSeconds(core.predictionLead);
+        if(core.deltaOutput)
+            updateSavedCommandsRate(time);
+
+        // With the delta output the vector is sent only when an intensity changes or has to be kept alive,
+        // otherwise it is sent in every cycle since it holds the state of all of the actuators
+        bool sendVector = outputMode==OutputMode::Vector && (!core.deltaOutput || !actuationCommands.empty());
+
+        // Send the commands only if there is something to actuate
+        if(actuationCommands.empty() && !sendVector)
+            return;
+
+        double serializeDuration = 0.0;
+        double writeDuration = 0.0;
+        if(outputMode==OutputMode::Vector)
         {
-            if(velocities[index]>maxJointVelocity)
+            // the delta output sends the changed intensities only, so the others keep their last value
+            stageStart = std::chrono::steady_clock::now();
+            if(!core.deltaOutput)
+                std::fill(actuatorIntensities.begin(), actuatorIntensities.end(), 0.0);
+            for(const WeightRetargetingCore::ActuationCommand& command : actuationCommands)
+                actuatorIntensities[command.actuator - core.groups.actuators.data()] = command.intensity;
+
+            yarp::sig::Vector& vectorCommand = vectorCommandPort.prepare();
+            vectorCommand.resize(actuatorIntensities.size());
+            std::copy(actuatorIntensities.begin(), actuatorIntensities.end(), vectorCommand.data());
+            serializeDuration = getElapsedTime(stageStart);
+
+            stageStart = std::chrono::steady_clock::now();
+            vectorCommandPort.write(true);
+            writeDuration = getElapsedTime(stageStart);
+        }
+        else if(outputMode==OutputMode::Batched)
+        {
+            // pack all the commands of the cycle in a single message
+            stageStart = std::chrono::steady_clock::now();
+            BatchedActuationCommand& batchedCommand = batchedCommandPort.prepare();
+            batchedCommand.clear(retargeting->actuatorNames);
+            for(const WeightRetargetingCore::ActuationCommand& command : actuationCommands)
+                batchedCommand.add(command.actuator - core.groups.actuators.data(), command.intensity);
+            serializeDuration = getElapsedTime(stageStart);
+
+            stageStart = std::chrono::steady_clock::now();
+            batchedCommandPort.write(true);
+            writeDuration = getElapsedTime(stageStart);
+        }
+        else
+        {
+            for(const WeightRetargetingCore::ActuationCommand& command : actuationCommands)
             {
-                return false;
+                stageStart = std::chrono::steady_clock::now();
+                wearable::msg::WearableActuatorCommand& wearableActuatorCommand = actuatorCommandPort.prepare();
+
+                wearableActuatorCommand.value = command.intensity;
+                wearableActuatorCommand.info.name = *command.actuator;
+                wearableActuatorCommand.info.type = wearable::msg::ActuatorType::HAPTIC;
+                wearableActuatorCommand.duration = 0;
+                serializeDuration += getElapsedTime(stageStart);
+
+                // Send haptic actuator command
+                stageStart = std::chrono::steady_clock::now();
+                actuatorCommandPort.write(true);
+                writeDuration += getElapsedTime(stageStart);
             }
         }
 
-        return true;
+        latencyStats.get(LatencyStats::Stage::Serialize).recordSeconds(serializeDuration);
+        latencyStats.get(LatencyStats::Stage::Write).recordSeconds(writeDuration);
+        latencyStats.get(LatencyStats::Stage::EndToEnd).recordSeconds(yarp::os::Time::now()-sample.measurementTime);
     }
 
     /**
-     * @brief Computes the actuation command value of a group
+     * @brief Publish the latency statistics if the publishing period has expired
      * 
-     * @param groupInfo the actuators group
-     * @return double the value of the actuation command
+     * @param time the current time in seconds
      */
-    double computeActuationIntensity(const ActuatorGroupInfo& groupInfo)
+    void publishLatencyStats(const double time)
     {
-        //check group velocity
-        if(useVelocities && !checkGroupVelocity(groupInfo))
+        if(latencyStatsPeriod<=0 || time-lastLatencyStatsTime<latencyStatsPeriod)
+            return;
+        lastLatencyStatsTime = time;
+
+        yarp::os::Bottle& statsMessage = latencyStatsPort.prepare();
+        statsMessage.clear();
+        for(size_t i=0; i<LatencyStats::NUMBER_OF_STAGES; i++)
         {
-            return 0;
+            const LatencyStats::Stage stage = static_cast<LatencyStats::Stage>(i);
+            const LatencyHistogram& histogram = latencyStats.get(stage);
+            yarp::os::Bottle& stageMessage = statsMessage.addList();
+            stageMessage.addString(LatencyStats::stageToString(stage));
+            stageMessage.addInt64(histogram.getCount());
+            stageMessage.addFloat64(histogram.getPercentile(50.0)*1e3);
+            stageMessage.addFloat64(histogram.getPercentile(99.0)*1e3);
+            stageMessage.addFloat64(histogram.getPercentile(99.9)*1e3);
+            stageMessage.addFloat64(histogram.getMax()*1e3);
         }
-        
-        // compute the norm
-        double norm = getNorm(groupInfo);
-        
-        // remove offset
-        norm = norm+groupInfo.offset;
-
-        return computeActuationIntensity(norm, groupInfo.minThreshold, groupInfo.maxThreshold);
+        latencyStatsPort.write();
     }
 
     /**
-     * @brief Retrieve data related to actuators groups from configuration
+     * @brief Run a control cycle of the instance, called by the scheduler of the module
      * 
-     * @param rf the ResourceFinder instance
-     * @return true if the reading was successful
-     * @return false otherwise
+     * @return true if the instance can continue
+     * @return false if the acquisition timeout has expired or the acquisition of the joints has been lost
      */
-    bool readActuatorsGroups(yarp::os::ResourceFinder &rf)
+    bool update()
     {
+        // skip the cycle if reloadConfig is swapping the retargeting
+        std::unique_lock<std::mutex> lock(retargetingMutex, std::try_to_lock);
+        if(!lock.owns_lock())
+            return true;
 
-        yarp::os::Bottle* actuatorGroupsBottle = rf.find("actuator_groups").asList();
-        if(actuatorGroupsBottle==nullptr)
+        // reloadConfig could neither acquire the new joints nor restore the current ones
+        if(acquisitionLost)
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: actuator_groups";
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The acquisition of the joints has been lost";
             return false;
         }
 
-        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter: actuator_groups";
-        for(int i=0; i<actuatorGroupsBottle->size(); i++)
+        auto currentTime = std::chrono::system_clock::now();
+        size_t allocationCount = AllocationCounter::getThreadCount();
+        
+        // take the latest sample published by the acquisition thread, without waiting for it
+        if(acquisition.updateSample())
         {
-            ActuatorGroupInfo groupInfo;
-            yarp::os::Bottle* groupInfoBottle = actuatorGroupsBottle->get(i).asList();
+            lastAcquisition = currentTime;
 
-            if(groupInfoBottle->size()!=CONFIG_GROUP_SIZE)
+            const JointAcquisition::JointSample& sample = acquisition.getSample();
+            double time = yarp::os::Time::now();
+            latencyStats.get(LatencyStats::Stage::Acquire).recordSeconds(sample.acquisitionDuration);
+            if(retargeting->core.useVelocities)
+                latencyStats.get(LatencyStats::Stage::VelocityRead).recordSeconds(sample.velocityReadDuration);
+            if(recorder.isOpen() && !recorder.write(time, sample.interfaceValues.data(), sample.velocities.data()))
             {
-                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The number of configuration parameter for group"<<i<<"is incorrect (must be"<<CONFIG_GROUP_SIZE<<")";
-                return false;
+                yCIWarningThrottle(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX, 5.0) << "Unable to record the sample";
             }
 
-            // get actuator group name
-            std::string groupName = groupInfoBottle->get(0).asString();
-            if(groupName=="all")
-            {
-                yCError(WEIGHT_RETARGETING_LOG_COMPONENT) << "All is a reserved name for actuator groups";
-                return false;
-            }
-            else if(actuatorGroupMap.find(groupName)!=actuatorGroupMap.end())
-            {
-                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Multiple definition of actuator group"<<groupName;
-                return false;
-            }
+            // generate the actuation commands, the parameters changed by the RPC are read without locking
+            generateGroupsActuation(sample, time);
 
-            //get axis names
-            std::vector<std::string> jointAxes;
-            yarp::os::Value& jointsList = groupInfoBottle->get(1);
-            if(jointsList.isList())
+            allocationCount = AllocationCounter::getThreadCount() - allocationCount;
+            if(allocationCount>0)
             {
-                yarp::os::Bottle* jointsListBottle = jointsList.asList();
-                for(int i=0;i<jointsListBottle->size(); i++)
-                {
-                    jointAxes.push_back(jointsListBottle->get(i).asString());
-                }
+                yCIWarningThrottle(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX, 5.0) << "Heap allocations in the control cycle:" << allocationCount;
             }
-            else
-            {
-                jointAxes.push_back(jointsList.asString());
-            }
-
-            //get min threshold
-            groupInfo.minThreshold = groupInfoBottle->get(2).asFloat64();
 
-            //get max threshold
-            groupInfo.maxThreshold = groupInfoBottle->get(3).asFloat64();
+        } else if(currentTime-lastAcquisition > ACQUISITION_TIMEOUT)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Data acquisition timeout has expired!";
+            return false;
+        }
 
-            //get list of actuators
-            yarp::os::Bottle* actuatorListBottle = groupInfoBottle->get(4).asList();
-            if(actuatorListBottle->size()==0)
-            {
-                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The actuators list of"<<groupName<<"is empty!";
-                return false;
-            }
+        publishLatencyStats(yarp::os::Time::now());
 
-            for(int j = 0; j<actuatorListBottle->size(); j++) 
-                groupInfo.actuators.push_back(actuatorListBottle->get(j).asString());
+        return true;
+    }
 
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added actuator group: name"<<groupName//TODO axes  <<"| Joint axis"<<jointAxes
-                                                      <<"| Min threshold"<< groupInfo.minThreshold << "| Max threshold"<< groupInfo.maxThreshold;
+    /**
+     * @brief Build the retargeting logic and allocate its buffers
+     * 
+     * @param config the configuration of the retargeting and of the actuator groups
+     * @return std::unique_ptr<Retargeting> the retargeting, nullptr if the configuration is not valid
+     */
+    std::unique_ptr<Retargeting> createRetargeting(const yarp::os::Searchable& config)
+    {
+        std::unique_ptr<Retargeting> newRetargeting = std::make_unique<Retargeting>();
+        if(!newRetargeting->core.configure(config))
+            return nullptr;
 
-            //add joint axis name to the list
-            for(std::string& axisName : jointAxes)
-            {
-                auto it = std::find(jointNames.begin(), jointNames.end(), axisName);
-                if(it==jointNames.end())
-                {
-                    groupInfo.jointIndexes.push_back(jointNames.size());
-                    jointNames.push_back(axisName);
-                }
-                else
-                {
-                    groupInfo.jointIndexes.push_back(it - jointNames.begin());
-                }
-            }
-            
-            // add group info to the map
-            groupInfo.offset = 0.0;
-            actuatorGroupMap[groupName] = groupInfo;
+        // the weight is acquired by the module for all of its instances
+        const WeightRetargetingCore& core = newRetargeting->core;
+        if(core.useWeight && weightAcquisition==nullptr)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The axis" << core.WEIGHT_AXIS_NAME << "requires the group WEIGHT_ACQUISITION in the configuration of the module";
+            return nullptr;
         }
-        
-        return true;
+        if(retargetedValue==RetargetedValue::Weight && !core.jointNames.empty())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Only the axis" << core.WEIGHT_AXIS_NAME << "can be retargeted when retargeted_value is weight";
+            return nullptr;
+        }
+
+        // use the control cycle specialized for the layout of the groups, if it has been generated at build time
+        if(selectSpecializedStages(newRetargeting->core))
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Using the control cycle specialized for the layout" << newRetargeting->core.specializedStages.layout;
+        else
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "No specialized layout matches the actuator groups, using the generic control cycle";
+
+        const size_t numberOfActuators = newRetargeting->core.groups.actuators.size();
+        newRetargeting->actuationCommands.reserve(numberOfActuators);
+        newRetargeting->actuatorIntensities.assign(numberOfActuators, 0.0);
+        newRetargeting->actuatorNames = std::make_shared<const std::vector<std::string>>(newRetargeting->core.groups.actuators);
+        return newRetargeting;
     }
 
     /**
-     * @brief Generates the actuation commands for all of the configured groups
+     * @brief Open the control boards of the retargeted joints, as a single remapper or as a board reader.
+     * The control boards in use are not affected, so that the new ones can be opened while the control cycle runs.
      * 
+     * @param core the retargeting logic
+     * @return std::unique_ptr<ControlBoard> the opened control boards, nullptr if they could not be opened
      */
-    void generateGroupsActuation()
+    std::unique_ptr<ControlBoard> openControlBoard(const WeightRetargetingCore& core)
     {
-        for(auto const & pair : actuatorGroupMap)
-        {
-            const ActuatorGroupInfo& actuatorGroupInfo = pair.second;
+        auto newControlBoard = std::make_unique<ControlBoard>();
+
+        // no joint is read if only the weight is retargeted
+        if(retargetedValue==RetargetedValue::Weight)
+            return newControlBoard;
 
-            double actuationIntensity = computeActuationIntensity(actuatorGroupInfo);
-            if(actuationIntensity>minIntensity)
+        // the local ports must not clash with the ones of the control boards still open
+        const std::string localPortPrefix = controlBoardGeneration==0 ? portPrefix+"/input" : portPrefix+"/input"+std::to_string(controlBoardGeneration);
+        controlBoardGeneration++;
+
+        if(acquisitionMode==AcquisitionMode::Parallel)
+        {
+            std::vector<std::string> remoteBoards;
+            for(const std::string& s : remoteControlBoards) remoteBoards.push_back(robotName+s);
+            if(!newControlBoard->boardReader.open(remoteBoards, localPortPrefix, core.jointNames, retargetedValue, core.useVelocities, *acquisitionPool))
             {
-                //send the haptic command to all the related actuators
-                for(const std::string& actuator : actuatorGroupInfo.actuators)
-                { 
-                    wearable::msg::WearableActuatorCommand& wearableActuatorCommand = actuatorCommandPort.prepare();
-
-                    wearableActuatorCommand.value = actuationIntensity;
-                    wearableActuatorCommand.info.name = IFEEL_SUIT_ACTUATOR_PREFIX+actuator;;
-                    wearableActuatorCommand.info.type = wearable::msg::ActuatorType::HAPTIC;
-                    wearableActuatorCommand.duration = 0;
-
-                    // Send haptic actuator command
-                    actuatorCommandPort.write(true);
-                }
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the control boards";
+                return nullptr;
             }
+            return newControlBoard;
         }
+
+        // configure the remapper
+        yarp::os::Property propRemapper;
+        propRemapper.put("device", "remotecontrolboardremapper");
+        // axes names
+        propRemapper.addGroup("axesNames");
+        yarp::os::Bottle& axesNamesBottle = propRemapper.findGroup("axesNames").addList();
+        for(const std::string& s : core.jointNames) axesNamesBottle.addString(s);
+        // remote control boards names
+        propRemapper.addGroup("remoteControlBoards");
+        yarp::os::Bottle& remoteControlBoardsNamesBottle = propRemapper.findGroup("remoteControlBoards").addList();
+        for(std::string& s : remoteControlBoards) remoteControlBoardsNamesBottle.addString(robotName+s);
+        // localPortPrefix
+        propRemapper.put("localPortPrefix", localPortPrefix);
+        yarp::os::Property& remoteControlBoardsOpts = propRemapper.addGroup("REMOTE_CONTROLBOARD_OPTIONS");
+        remoteControlBoardsOpts.put("writeStrict", "off");
+
+        // open the remapped control board
+        if(!newControlBoard->remapper.open(propRemapper))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the ControlBoardRemapper";
+            return nullptr;
+        }
+        return newControlBoard;
     }
 
-    bool updateModule() override
+    void closeControlBoard(ControlBoard& board)
     {
-        std::lock_guard<std::mutex> guard(mutex);
-        auto currentTime = std::chrono::system_clock::now();
-        
-        // get the data 
-        std::vector<double> buffer;
-        bool acquisitionResult = false;
-        buffer.resize(jointNames.size());
-        switch (retargetedValue)
-        {
-        case RetargetedValue::JointTorque : acquisitionResult = iTorqueControl->getTorques(buffer.data()); break;
-        case RetargetedValue::MotorCurrent : acquisitionResult = iCurrentControl->getCurrents(buffer.data()); break;
-        default: acquisitionResult = false; break;
-        } 
-
-        // check if acquisition was successful
-        if(acquisitionResult)
-        {
-            // update internal data only if acquisition is successful
-            for(int i=0;i<jointNames.size();i++)
-            {
-                interfaceValues[i] = buffer[i];
-            }
+        if(retargetedValue==RetargetedValue::Weight)
+            return;
 
-            lastAcquisition = currentTime;
+        if(acquisitionMode==AcquisitionMode::Parallel)
+            board.boardReader.close();
+        else
+            board.remapper.close();
+    }
 
-            // get the velocities
-            if(useVelocities)
-            {
-                if(iEncodersTimed->getEncoderSpeeds(buffer.data()))
-                {
-                    for(int i=0;i<jointNames.size();i++)
-                    {
-                        velocities[i] = buffer[i];
-                    }
-                }
-            }
+    /**
+     * @brief Configure the acquisition of the joints of a retargeting and add it to the acquisition thread
+     * 
+     * @param core the retargeting logic
+     * @param board the control boards of the joints of the retargeting
+     * @return true if the acquisition has been configured
+     * @return false otherwise
+     */
+    bool configureAcquisition(const WeightRetargetingCore& core, ControlBoard& board)
+    {
+        // the weight, if retargeted, is acquired after the joints
+        const WeightAcquisition* weight = core.useWeight ? weightAcquisition : nullptr;
+        bool result = false;
+        if(retargetedValue==RetargetedValue::Weight)
+            result = acquisition.configure(*weightAcquisition);
+        else if(acquisitionMode==AcquisitionMode::Parallel)
+            result = acquisition.configure(board.boardReader, core.useVelocities, core.jointNames.size(), weight);
+        else
+            result = acquisition.configure(board.remapper, retargetedValue, core.useVelocities, core.jointNames.size(), weight);
+        if(!result)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to configure the acquisition";
+            return false;
+        }
+        acquisitionThread->add(acquisition);
+        return true;
+    }
 
-            // generate the actuation commands
-            generateGroupsActuation();
+    /**
+     * @brief Stop the acquisition and start it again for the joints of a retargeting
+     * 
+     * @param core the retargeting logic
+     * @param board the control boards of the joints of the retargeting, already open
+     * @return true if the acquisition has been restarted
+     * @return false otherwise
+     */
+    bool restartAcquisition(const WeightRetargetingCore& core, ControlBoard& board)
+    {
+        // the acquisitions of the other instances continue
+        acquisitionThread->remove(acquisition);
 
-        } else if(currentTime-lastAcquisition > ACQUISITION_TIMEOUT)
+        if(!configureAcquisition(core, board))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Data acquisition timeout has expired!";
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to restart the acquisition";
             return false;
         }
-
         return true;
     }
 
-    bool configure(yarp::os::ResourceFinder &rf) override
+    /**
+     * @brief Configure the instance and add its acquisition to the acquisition thread
+     * 
+     * @param config the configuration of the instance
+     * @param name the name of the instance, empty if the module hosts a single instance
+     * @param configFile the configuration file, read again by reloadConfig
+     * @param acquisitionThread the acquisition thread shared by the instances, which must outlive the instance
+     * @param acquisitionPool the pool of threads reading the boards shared by the instances, which must outlive the instance
+     * @param weightAcquisition the weight held by the end effectors, updated by the acquisition thread, nullptr if it is not acquired
+     * @return true if the instance has been configured
+     * @return false otherwise
+     */
+    bool configure(const yarp::os::Searchable& config, const std::string& name, const std::string& configFile,
+                   JointAcquisitionThread& acquisitionThread, TaskPool& acquisitionPool, const WeightAcquisition* weightAcquisition)
     {
-        bool result = true;
+        this->configFile = configFile;
+        configSection = name;
+        this->acquisitionThread = &acquisitionThread;
+        this->acquisitionPool = &acquisitionPool;
+        this->weightAcquisition = weightAcquisition;
+
+        // read port_prefix param
+        portPrefix = name.empty() ? "/WeightRetargeting" : "/WeightRetargeting/"+name;
+        if(!config.check("port_prefix"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter port_prefix, using default value" << portPrefix;
+        } else
+        {
+            portPrefix = config.find("port_prefix").asString();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter port_prefix:" << portPrefix;
+        }
 
         // read robot name
-        std::string robotName = rf.find("robot").asString();
+        robotName = config.find("robot").asString();
         if(robotName.empty())
         {
             yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: robot";
@@ -364,146 +552,148 @@ public:
             robotName = "/"+robotName;
         }
 
-        // read period param
-        if(!rf.check("period"))
+        // read retargeted_value param
+        if(!config.check("retargeted_value"))
         {
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter period, using default value" << period;
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: retargeted_value";
+            return false;
         } else 
         {
-            period = rf.find("period").asFloat64();
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter period:" << period;
+            retargetedValue = JointAcquisition::retargetedValuefromString(config.find("retargeted_value").asString());
+            if(retargetedValue==RetargetedValue::Invalid)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid retargeted_value value:"<< config.find("retargeted_value").asString();
+                return false;
+            }
         }
 
-        // read use_velocity param
-        if(!rf.check("use_velocity"))
+        // read output_mode param
+        if(!config.check("output_mode"))
         {
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter use_velocity, using default value" << useVelocities;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter output_mode, using default value per_actuator";
         } else 
         {
-            useVelocities = rf.find("use_velocity").asBool();
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter use_velocity:" << useVelocities;
-        }
-
-        if(useVelocities)
-        {
-            if(!rf.check("max_velocity"))
-            {
-                yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter max_velocity, using default value" << maxJointVelocity;
-            } else 
+            outputMode = outputModefromString(config.find("output_mode").asString());
+            if(outputMode==OutputMode::Invalid)
             {
-                maxJointVelocity = rf.find("max_velocity").asFloat64();
-                yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter max_velocity:" << maxJointVelocity;
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid output_mode value:"<< config.find("output_mode").asString();
+                return false;
             }
-        }   
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter output_mode:" << config.find("output_mode").asString();
+        }
 
-        // read retargeted_value param
-        if(!rf.check("retargeted_value"))
+        // read acquisition_mode param
+        if(!config.check("acquisition_mode"))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: retargeted_value";
-            return false;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter acquisition_mode, using default value remapper";
         } else 
         {
-            retargetedValue = retargetedValuefromString(rf.find("retargeted_value").asString());
-            if(retargetedValue==RetargetedValue::Invalid)
+            acquisitionMode = acquisitionModefromString(config.find("acquisition_mode").asString());
+            if(acquisitionMode==AcquisitionMode::Invalid)
             {
-                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid retargeted_value value:"<< rf.find("retargeted_value").asString();
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid acquisition_mode value:"<< config.find("acquisition_mode").asString();
                 return false;
             }
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter acquisition_mode:" << config.find("acquisition_mode").asString();
         }
 
-        // read min_actuation param
-        if(!rf.check("min_intensity"))
+        // read remote_boards param, not needed if only the weight is retargeted
+        yarp::os::Bottle* remoteBoardsBottle = config.find("remote_boards").asList();
+        if(remoteBoardsBottle==nullptr && retargetedValue==RetargetedValue::Weight)
         {
-            yCDebug(WEIGHT_RETARGETING_LOG_COMPONENT) << "Missing parameter min_intensity, using default value" << minIntensity;
-        } else 
-        {
-            minIntensity = rf.find("min_intensity").asFloat64();
-            yCDebug(WEIGHT_RETARGETING_LOG_COMPONENT) << "Found parameter min_intensity:" << minIntensity;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter remote_boards, only the weight is retargeted";
         }
-
-        // read remote_boards param 
-        yarp::os::Bottle* remoteBoardsBottle = rf.find("remote_boards").asList();
-        if(remoteBoardsBottle==nullptr)
+        else if(remoteBoardsBottle==nullptr)
         {
             yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: remote_boards";
             return false;
         }
-
-        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter remote_boards";
-        for(int i=0;i<remoteBoardsBottle->size();i++)
+        else
         {
-            std::string remoteBoard = remoteBoardsBottle->get(i).asString();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter remote_boards";
+            for(size_t i=0;i<remoteBoardsBottle->size();i++)
+            {
+                std::string remoteBoard = remoteBoardsBottle->get(i).asString();
 
-            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added remote control board:" << remoteBoard;
+                yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added remote control board:" << remoteBoard;
 
-            if(remoteBoard[0]!='/') remoteBoard = "/"+remoteBoard;
-            remoteControlBoards.push_back(remoteBoard);
-        } 
+                if(remoteBoard[0]!='/') remoteBoard = "/"+remoteBoard;
+                remoteControlBoards.push_back(remoteBoard);
+            }
+        }
         
-        // Read information about the actuator groups
-        if(!readActuatorsGroups(rf))
+        // Read the parameters of the retargeting and the actuator groups
+        retargeting = createRetargeting(config);
+        if(!retargeting)
             return false;
+        const WeightRetargetingCore& core = retargeting->core;
 
-        // configure the remapper
-        yarp::os::Property propRemapper;
-        propRemapper.put("device", "remotecontrolboardremapper");
-        // axes names
-        propRemapper.addGroup("axesNames");
-        yarp::os::Bottle& axesNamesBottle = propRemapper.findGroup("axesNames").addList();
-        for(std::string& s : jointNames) axesNamesBottle.addString(s);
-        // remote control boards names
-        propRemapper.addGroup("remoteControlBoards");
-        yarp::os::Bottle& remoteControlBoardsNamesBottle = propRemapper.findGroup("remoteControlBoards").addList();
-        for(std::string& s : remoteControlBoards) remoteControlBoardsNamesBottle.addString(robotName+s);
-        // localPortPrefix
-        propRemapper.put("localPortPrefix", "/WeightRetargeting/input");
-        yarp::os::Property& remoteControlBoardsOpts = propRemapper.addGroup("REMOTE_CONTROLBOARD_OPTIONS");
-        remoteControlBoardsOpts.put("writeStrict", "off");
+        // open the remapped control board and configure the acquisition thread
+        controlBoard = openControlBoard(core);
+        if(!controlBoard || !configureAcquisition(core, *controlBoard))
+            return false;
 
-        // open the remapped control board
-        result = remappedControlBoard.open(propRemapper);
-        if(!result)
+        // read latency_stats_period param
+        if(!config.check("latency_stats_period"))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the ControlBoardRemapper";
-            return result;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter latency_stats_period, using default value" << latencyStatsPeriod;
+        } else
+        {
+            latencyStatsPeriod = config.find("latency_stats_period").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter latency_stats_period:" << latencyStatsPeriod;
         }
 
-        // get the interface related to the corresponding retargeted value
-        switch(retargetedValue)
+        // read record_file param
+        if(!config.check("record_file"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter record_file, the samples will not be recorded";
+        } else
         {
-        case RetargetedValue::JointTorque: result = remappedControlBoard.view(iTorqueControl); break;
-        case RetargetedValue::MotorCurrent: result = remappedControlBoard.view(iCurrentControl); break;
-        default : result = false;
+            std::string recordFile = config.find("record_file").asString();
+            if(!recorder.open(recordFile, TickRecordingHeader::Source::Retargeting, core.getNumberOfValues(), core.getNumberOfValues()))
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the record file" << recordFile;
+                return false;
+            }
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Recording the samples in" << recordFile;
         }
 
-        if(!result)
+        std::string wearableActuatorCommandPortName = portPrefix+"/output:o";
+
+        // Initialize actuator command port and connect to command input port
+        if(!actuatorCommandPort.open(wearableActuatorCommandPortName))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get torque control interface";
-            return result;
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to open" << actuatorCommandPort.getName();
+            return false;
         }
 
-        // get the interface for the velocity if needed
-        if(useVelocities && !remappedControlBoard.view(iEncodersTimed))
+        // Initialize the batched command port
+        std::string batchedCommandPortName = portPrefix+"/batched_output:o";
+        if(outputMode==OutputMode::Batched && !batchedCommandPort.open(batchedCommandPortName))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to get encodersTimed interface";
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to open" << batchedCommandPortName;
             return false;
         }
 
-        interfaceValues.resize(jointNames.size());
-        velocities.resize(jointNames.size());
-
-        std::string wearableActuatorCommandPortName = "/WeightRetargeting/output:o";//TODO config
+        // Initialize the vector command port
+        std::string vectorCommandPortName = portPrefix+"/vector_output:o";
+        if(outputMode==OutputMode::Vector && !vectorCommandPort.open(vectorCommandPortName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to open" << vectorCommandPortName;
+            return false;
+        }
 
-        // Initialize actuator command port and connect to command input port
-        if(!actuatorCommandPort.open(wearableActuatorCommandPortName))
+        // Initialize the latency statistics port
+        std::string latencyStatsPortName = portPrefix+"/latency:o";
+        if(latencyStatsPeriod>0 && !latencyStatsPort.open(latencyStatsPortName))
         {
-            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to open" << actuatorCommandPort.getName();
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Failed to open" << latencyStatsPortName;
             return false;
         }
 
         // Initialize RPC
         this->yarp().attachAsServer(rpcPort);
-        std::string rpcPortName = "/WeightRetargeting/rpc:i"; //TODO from config?
+        std::string rpcPortName = portPrefix+"/rpc:i";
         // open the RPC port
         if(!rpcPort.open(rpcPortName))
         {
@@ -517,75 +707,430 @@ public:
         }
 
         lastAcquisition = std::chrono::system_clock::now();
+        savedCommandsWindowStart = yarp::os::Time::now();
 
-        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT,  LOG_PREFIX) << "Module started successfully!";
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT,  LOG_PREFIX) << "Instance" << portPrefix << "configured successfully!";
 
         return true;
     }
 
-    bool close() override
+    void close()
     {
+        if(acquisitionThread!=nullptr)
+            acquisitionThread->remove(acquisition);
+        if(controlBoard)
+            closeControlBoard(*controlBoard);
+
         actuatorCommandPort.close();
-        return true;
+        if(outputMode==OutputMode::Batched)
+            batchedCommandPort.close();
+        if(outputMode==OutputMode::Vector)
+            vectorCommandPort.close();
+        if(latencyStatsPeriod>0)
+            latencyStatsPort.close();
+
+        recorder.close();
     }
 
     bool setMaxThreshold(const std::string& actuatorGroup, const double value) override
     {
-        std::lock_guard<std::mutex> guard(mutex);
-        if(actuatorGroupMap.find(actuatorGroup)==actuatorGroupMap.end())
+        return retargeting->core.setMaxThreshold(actuatorGroup, value);
+    }
+
+    bool setMinThreshold(const std::string& actuatorGroup, const double value) override
+    {
+        return retargeting->core.setMinThreshold(actuatorGroup, value);
+    }
+
+    bool setThresholds(const std::string& actuatorGroup, const double minThreshold, const double maxThreshold) override
+    {
+        return retargeting->core.setThresholds(actuatorGroup, minThreshold, maxThreshold);
+    }
+
+    bool setIntensityCurve(const std::string& actuatorGroup, const std::string& curve, const std::vector<double>& parameters) override
+    {
+        return retargeting->core.setIntensityCurve(actuatorGroup, curve, parameters);
+    }
+
+    double getSavedCommandsRate() override
+    {
+        return savedCommandsRate;
+    }
+
+    bool removeOffset(const std::string& actuatorGroup) override
+    {
+        return retargeting->core.removeOffset(actuatorGroup);
+    }
+
+    CalibrationStatus getCalibrationStatus() override
+    {
+        CalibrationStatus status;
+        const WeightRetargetingCore& core = retargeting->core;
+        const int group = core.calibrationRequestedGroup;
+        status.state = WeightRetargetingCore::calibrationStateToString(core.calibrationState);
+        status.actuatorGroup = group<0 ? "all" : core.groups.names[group];
+        status.collectedSamples = core.calibrationCollectedSamples;
+        status.maxSamples = core.calibrationSamples;
+        return status;
+    }
+
+    std::vector<LatencyStageStats> getLatencyStats() override
+    {
+        std::vector<LatencyStageStats> stats(LatencyStats::NUMBER_OF_STAGES);
+        for(size_t i=0; i<LatencyStats::NUMBER_OF_STAGES; i++)
+        {
+            const LatencyStats::Stage stage = static_cast<LatencyStats::Stage>(i);
+            const LatencyHistogram& histogram = latencyStats.get(stage);
+            stats[i].stage = LatencyStats::stageToString(stage);
+            stats[i].count = histogram.getCount();
+            stats[i].p50 = histogram.getPercentile(50.0);
+            stats[i].p99 = histogram.getPercentile(99.0);
+            stats[i].p999 = histogram.getPercentile(99.9);
+            stats[i].max = histogram.getMax();
+        }
+        return stats;
+    }
+
+    std::vector<std::string> getActuatorOrder() override
+    {
+        return retargeting->core.groups.actuators;
+    }
+
+    bool reloadConfig() override
+    {
+        yarp::os::Property configFileContent;
+        if(configFile.empty() || !configFileContent.fromConfigFile(configFile))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to read the configuration file" << configFile;
+            return false;
+        }
+
+        // the instances hosted together read their own section
+        const yarp::os::Searchable& config = configSection.empty() ? static_cast<const yarp::os::Searchable&>(configFileContent)
+                                                                   : configFileContent.findGroup(configSection);
+        if(config.isNull())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing section" << configSection << "in the configuration file" << configFile;
+            return false;
+        }
+
+        // build the new retargeting outside of the control cycle
+        std::unique_ptr<Retargeting> newRetargeting = createRetargeting(config);
+        if(!newRetargeting)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid configuration, the current one is kept";
+            return false;
+        }
+
+        // the acquisition is restarted only if it reads different data, and the control board only if the joints changed
+        const WeightRetargetingCore& newCore = newRetargeting->core;
+        const WeightRetargetingCore& currentCore = retargeting->core;
+        const bool jointsChanged = newCore.jointNames!=currentCore.jointNames;
+        const bool acquisitionChanged = jointsChanged || newCore.useVelocities!=currentCore.useVelocities || newCore.useWeight!=currentCore.useWeight;
+        if(acquisitionChanged && recorder.isOpen())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The acquired joints cannot change while recording, the current configuration is kept";
+            return false;
+        }
+
+        // the receivers of the vector output index the intensities with the order read once from getActuatorOrder
+        if(outputMode==OutputMode::Vector && newCore.groups.actuators!=currentCore.groups.actuators)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The actuators and their order cannot change with the vector output, the current configuration is kept";
+            return false;
+        }
+
+        // open the control boards of the new joints while the control cycle runs, only the acquisition is restarted in the swap.
+        // The board reader is always opened again, since it reads the velocities only if they are used.
+        std::unique_ptr<ControlBoard> newControlBoard;
+        if(acquisitionChanged && (jointsChanged || acquisitionMode==AcquisitionMode::Parallel))
+        {
+            newControlBoard = openControlBoard(newCore);
+            if(!newControlBoard)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the control boards of the new configuration, the current one is kept";
+                return false;
+            }
+        }
+
+        bool result = true;
+        {
+            // wait for the end of the current cycle, the next ones are skipped until the swap is done
+            std::lock_guard<std::mutex> guard(retargetingMutex);
+            ControlBoard& newBoard = newControlBoard ? *newControlBoard : *controlBoard;
+            if(acquisitionChanged && !restartAcquisition(newCore, newBoard))
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to acquire the joints of the new configuration, restoring the current one";
+                if(!restartAcquisition(currentCore, *controlBoard))
+                {
+                    yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to restore the acquisition of the current configuration, the instance is stopped";
+                    acquisitionLost = true;
+                }
+                lastAcquisition = std::chrono::system_clock::now();
+                result = false;
+            }
+            else
+            {
+                if(newControlBoard)
+                    controlBoard.swap(newControlBoard);
+                retargeting.swap(newRetargeting);
+                lastAcquisition = std::chrono::system_clock::now();
+                savedCommandsWindowStart = yarp::os::Time::now();
+                savedCommandsWindowCount = 0;
+            }
+        }
+
+        // the control boards and the retargeting not used anymore are released outside of the control cycle
+        if(newControlBoard)
+            closeControlBoard(*newControlBoard);
+        if(!result)
             return false;
 
-        actuatorGroupMap[actuatorGroup].maxThreshold = value;
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Reloaded" << retargeting->core.groups.size() << "actuator groups from" << configFile
+                                                  << (acquisitionChanged ? "| acquisition restarted" : "| acquisition kept");
         return true;
     }
 
-    bool setMinThreshold(const std::string& actuatorGroup, const double value) override
+    std::vector<LatencyStageStats> getBoardReadStats() override
     {
-        std::lock_guard<std::mutex> guard(mutex);
-        if(actuatorGroupMap.find(actuatorGroup)==actuatorGroupMap.end())
-            return false;
+        ParallelBoardReader& boardReader = controlBoard->boardReader;
+        std::vector<LatencyStageStats> stats(boardReader.getNumberOfBoards());
+        for(size_t i=0; i<stats.size(); i++)
+        {
+            const LatencyHistogram& histogram = boardReader.getBoardReadTimes(i);
+            stats[i].stage = boardReader.getBoardName(i);
+            stats[i].count = histogram.getCount();
+            stats[i].p50 = histogram.getPercentile(50.0);
+            stats[i].p99 = histogram.getPercentile(99.0);
+            stats[i].p999 = histogram.getPercentile(99.9);
+            stats[i].max = histogram.getMax();
+        }
+        return stats;
+    }
 
-        actuatorGroupMap[actuatorGroup].minThreshold = value;
+    bool resetLatencyStats() override
+    {
+        latencyStats.reset();
+        ParallelBoardReader& boardReader = controlBoard->boardReader;
+        for(size_t i=0; i<boardReader.getNumberOfBoards(); i++)
+            boardReader.getBoardReadTimes(i).reset();
         return true;
     }
 
-    bool setThresholds(const std::string& actuatorGroup, const double minThreshold, const double maxThreshold) override
+};
+
+/**
+ * @brief Module hosting the retargeting instances listed in the configuration, each in its own section.
+ * The instances are updated by the thread of the module and acquired by a single acquisition thread,
+ * whose pool of threads reads the boards of the instances in parallel mode.
+ */
+class WeightRetargetingModule : public yarp::os::RFModule
+{
+public:
+
+    const std::string LOG_PREFIX = "HapticModule";
+
+    double period = 0.02; //Default 50Hz
+
+    // Data acquisition shared by the instances
+    double acquisitionPeriod = period;
+    std::unique_ptr<JointAcquisitionThread> acquisitionThread;
+    TaskPool acquisitionPool;
+
+    // Weight held by the end effectors, read from the wrenches once for all of the instances retargeting it
+    std::unique_ptr<WeightAcquisition> weightAcquisition;
+
+    std::vector<std::unique_ptr<WeightRetargetingInstance>> instances;
+    std::vector<bool> failedInstances; // instances stopped by a failed update, already closed
+
+    /**
+     * @brief Open the acquisition of the weight if the WEIGHT_ACQUISITION group is in the configuration
+     * 
+     * @param rf the configuration of the module
+     * @return true if the group is missing or the weight acquisition has been opened
+     * @return false otherwise
+     */
+    bool configureWeightAcquisition(yarp::os::ResourceFinder &rf)
     {
-        std::lock_guard<std::mutex> guard(mutex);
-        if(actuatorGroupMap.find(actuatorGroup)==actuatorGroupMap.end())
-            return false;
+        yarp::os::Bottle weightGroup = rf.findGroup("WEIGHT_ACQUISITION");
+        if(weightGroup.isNull())
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Group WEIGHT_ACQUISITION not found, the weight will not be retargeted";
+            return true;
+        }
 
-        actuatorGroupMap[actuatorGroup].minThreshold = minThreshold;
-        actuatorGroupMap[actuatorGroup].maxThreshold = maxThreshold;
+        // read port_prefix param
+        std::string weightPortPrefix = "/WeightRetargeting/weight";
+        if(!weightGroup.check("port_prefix"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter port_prefix of WEIGHT_ACQUISITION, using default value" << weightPortPrefix;
+        } else 
+        {
+            weightPortPrefix = weightGroup.find("port_prefix").asString();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter port_prefix of WEIGHT_ACQUISITION:" << weightPortPrefix;
+        }
+
+        weightAcquisition = std::make_unique<WeightAcquisition>();
+        if(!weightAcquisition->configure(weightGroup, weightPortPrefix))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to configure the acquisition of the weight";
+            return false;
+        }
+        acquisitionThread->setWeightAcquisition(*weightAcquisition);
         return true;
     }
 
-    void removeSingleOffset(const std::string& actuatorGroup)
+    double getPeriod() override
+    {
+        return period;
+    }
+
+    bool updateModule() override
     {
-        ActuatorGroupInfo& groupInfo = actuatorGroupMap[actuatorGroup];
+        // a failed instance is closed, while the other instances continue
+        size_t runningInstances = 0;
+        for(size_t i=0; i<instances.size(); i++)
+        {
+            if(failedInstances[i])
+                continue;
+            if(!instances[i]->update())
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The instance" << instances[i]->portPrefix << "failed, it is stopped";
+                instances[i]->close();
+                failedInstances[i] = true;
+                continue;
+            }
+            runningInstances++;
+        }
 
-        actuatorGroupMap[actuatorGroup].offset = groupInfo.minThreshold - getNorm(groupInfo);
+        if(runningInstances==0)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "All of the instances failed";
+            return false;
+        }
+        return true;
     }
 
-    bool removeOffset(const std::string& actuatorGroup) override
+    bool configure(yarp::os::ResourceFinder &rf) override
     {
-        std::lock_guard<std::mutex> guard(mutex);
-        if(actuatorGroup=="all")
+        // read period param
+        if(!rf.check("period"))
         {
-            for(auto const & pair : actuatorGroupMap)
-                removeSingleOffset(pair.first);
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter period, using default value" << period;
+        } else 
+        {
+            period = rf.find("period").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter period:" << period;
         }
-        else
+
+        // read acquisition_period param
+        if(!rf.check("acquisition_period"))
+        {
+            acquisitionPeriod = period;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter acquisition_period, using the value of period" << acquisitionPeriod;
+        } else 
+        {
+            acquisitionPeriod = rf.find("acquisition_period").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter acquisition_period:" << acquisitionPeriod;
+        }
+
+        // read instances param, the sections of the configuration defining the instances
+        std::vector<std::string> instanceNames;
+        if(!rf.check("instances"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter instances, using a single instance configured by the whole file";
+            instanceNames.push_back("");
+        } else 
+        {
+            yarp::os::Bottle* instancesBottle = rf.find("instances").asList();
+            if(instancesBottle==nullptr || instancesBottle->size()==0)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter instances must be a non-empty list";
+                return false;
+            }
+            for(size_t i=0; i<instancesBottle->size(); i++)
+            {
+                std::string name = instancesBottle->get(i).asString();
+                if(name.empty() || std::find(instanceNames.begin(), instanceNames.end(), name)!=instanceNames.end())
+                {
+                    yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid or duplicated instance name:" << name;
+                    return false;
+                }
+                instanceNames.push_back(name);
+            }
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter instances:" << instancesBottle->toString();
+        }
+
+        // configure the instances, whose acquisitions are started together
+        acquisitionThread = std::make_unique<JointAcquisitionThread>(acquisitionPeriod);
+        if(!configureWeightAcquisition(rf))
+            return false;
+        const std::string configFile = rf.findFile("from");
+        size_t numberOfBoards = 1;
+        for(const std::string& name : instanceNames)
         {
-            if(actuatorGroupMap.find(actuatorGroup)==actuatorGroupMap.end())
+            const yarp::os::Searchable& config = name.empty() ? static_cast<const yarp::os::Searchable&>(rf) : rf.findGroup(name);
+            if(config.isNull())
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing section of the instance" << name;
+                return false;
+            }
+
+            instances.push_back(std::make_unique<WeightRetargetingInstance>());
+            if(!instances.back()->configure(config, name, configFile, *acquisitionThread, acquisitionPool, weightAcquisition.get()))
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to configure the instance" << name;
+                return false;
+            }
+            numberOfBoards = std::max(numberOfBoards, instances.back()->controlBoard->boardReader.getNumberOfBoards());
+        }
+        failedInstances.assign(instances.size(), false);
+
+        // read acquisition_threads param, the threads reading the boards of the instances in parallel mode
+        size_t acquisitionThreads = numberOfBoards;
+        if(!rf.check("acquisition_threads"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter acquisition_threads, using one thread per control board" << acquisitionThreads;
+        } else 
+        {
+            int threads = rf.find("acquisition_threads").asInt32();
+            if(threads<1)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter acquisition_threads must be positive";
                 return false;
-            
-            removeSingleOffset(actuatorGroup);
+            }
+            acquisitionThreads = threads;
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter acquisition_threads:" << acquisitionThreads;
+        }
+        acquisitionPool.start(acquisitionThreads);
+
+        // start the acquisition
+        if(!acquisitionThread->start())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to start the acquisition thread";
+            return false;
         }
 
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT,  LOG_PREFIX) << "Module started successfully with" << instances.size() << "instances!";
         return true;
     }
 
+    bool close() override
+    {
+        if(acquisitionThread && acquisitionThread->isRunning())
+            acquisitionThread->stop();
+        for(size_t i=0; i<instances.size(); i++)
+        {
+            if(i>=failedInstances.size() || !failedInstances[i])
+                instances[i]->close();
+        }
+        instances.clear();
+        failedInstances.clear();
+        if(weightAcquisition)
+            weightAcquisition->close();
+        acquisitionPool.stop();
+        return true;
+    }
 };
 
 int main(int argc, char * argv[])
@@ -0,0 +1,1200 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/LogStream.h>
+
+#include "WeightRetargetingCore.h"
+#include "WeightRetargetingLogComponent.h"
+
+bool WeightRetargetingCore::getGroupIndex(const std::string& actuatorGroup, size_t& index) const
+{
+    auto it = groupIndexMap.find(actuatorGroup);
+    if(it==groupIndexMap.end())
+        return false;
+
+    index = it->second;
+    return true;
+}
+
+std::string WeightRetargetingCore::calibrationStateToString(const CalibrationState state)
+{
+    switch(state)
+    {
+    case CalibrationState::Idle: return "idle";
+    case CalibrationState::Requested: return "requested";
+    case CalibrationState::Collecting: return "collecting";
+    case CalibrationState::Committing: return "committing";
+    default: return "invalid";
+    }
+}
+
+WeightRetargetingCore::CalibrationEstimator WeightRetargetingCore::calibrationEstimatorFromString(const std::string& name)
+{
+    if(name=="mean")
+        return CalibrationEstimator::Mean;
+    if(name=="median")
+        return CalibrationEstimator::Median;
+    return CalibrationEstimator::Invalid;
+}
+
+double WeightRetargetingCore::getNorm(const size_t group, const std::vector<double>& interfaceValues) const
+{
+    double sum = 0;
+    for(int i=groups.jointOffsets[group]; i<groups.jointOffsets[group+1]; i++)
+    {
+        const double value = interfaceValues[groups.jointIndexes[i]];
+        sum += value * value;
+    }
+    return std::sqrt(sum);
+}
+
+double WeightRetargetingCore::computeActuationIntensity(const double measuredValue, const double minThreshold, const double maxThreshold)
+{
+    return RetargetingKernel::computeActuationIntensity(measuredValue, minThreshold, maxThreshold);
+}
+
+bool WeightRetargetingCore::checkGroupVelocity(const size_t group, const std::vector<double>& velocities) const
+{
+    for(int i=groups.jointOffsets[group]; i<groups.jointOffsets[group+1]; i++)
+    {
+        if(velocities[groups.jointIndexes[i]]>maxJointVelocity)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+double WeightRetargetingCore::computeActuationIntensity(const size_t group, const GroupParameters& groupParameters, const std::vector<double>& interfaceValues, const std::vector<double>& velocities) const
+{
+    //check group velocity
+    if(useVelocities && !checkGroupVelocity(group, velocities))
+    {
+        return 0;
+    }
+    
+    // compute the norm
+    double norm = getNorm(group, interfaceValues);
+    
+    // remove offset
+    norm = norm+groupParameters.offsets[group];
+
+    return computeActuationIntensity(norm, groupParameters.minThresholds[group], groupParameters.maxThresholds[group]);
+}
+
+bool WeightRetargetingCore::configure(const yarp::os::Searchable& config)
+{
+    // read use_velocity param
+    if(!config.check("use_velocity"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter use_velocity, using default value" << useVelocities;
+    } else 
+    {
+        useVelocities = config.find("use_velocity").asBool();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter use_velocity:" << useVelocities;
+    }
+
+    if(useVelocities)
+    {
+        if(!config.check("max_velocity"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter max_velocity, using default value" << maxJointVelocity;
+        } else 
+        {
+            maxJointVelocity = config.find("max_velocity").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter max_velocity:" << maxJointVelocity;
+        }
+    }   
+
+    // read min_actuation param
+    if(!config.check("min_intensity"))
+    {
+        yCDebug(WEIGHT_RETARGETING_LOG_COMPONENT) << "Missing parameter min_intensity, using default value" << minIntensity;
+    } else 
+    {
+        minIntensity = config.find("min_intensity").asFloat64();
+        yCDebug(WEIGHT_RETARGETING_LOG_COMPONENT) << "Found parameter min_intensity:" << minIntensity;
+    }
+
+    // read delta_output param
+    if(!config.check("delta_output"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter delta_output, using default value" << deltaOutput;
+    } else 
+    {
+        deltaOutput = config.find("delta_output").asBool();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter delta_output:" << deltaOutput;
+    }
+
+    if(deltaOutput)
+    {
+        if(!config.check("keep_alive_period"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter keep_alive_period, using default value" << keepAlivePeriod;
+        } else 
+        {
+            keepAlivePeriod = config.find("keep_alive_period").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter keep_alive_period:" << keepAlivePeriod;
+        }
+    }
+
+    // read calibration_samples param
+    if(!config.check("calibration_samples"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter calibration_samples, using default value" << calibrationSamples;
+    } else 
+    {
+        calibrationSamples = config.find("calibration_samples").asInt32();
+        if(calibrationSamples<1)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter calibration_samples must be positive";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter calibration_samples:" << calibrationSamples;
+    }
+
+    // read calibration_duration param
+    if(!config.check("calibration_duration"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter calibration_duration, using default value" << calibrationDuration;
+    } else 
+    {
+        calibrationDuration = config.find("calibration_duration").asFloat64();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter calibration_duration:" << calibrationDuration;
+    }
+
+    // read calibration_estimator param
+    if(!config.check("calibration_estimator"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter calibration_estimator, using default value median";
+    } else 
+    {
+        std::string estimatorName = config.find("calibration_estimator").asString();
+        calibrationEstimator = calibrationEstimatorFromString(estimatorName);
+        if(calibrationEstimator==CalibrationEstimator::Invalid)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid calibration_estimator" << estimatorName << "(must be mean or median)";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter calibration_estimator:" << estimatorName;
+    }
+
+    // read the actuator groups, their filters and their curves
+    if(!readActuatorsGroups(config))
+        return false;
+
+    if(!readGroupFilters(config))
+        return false;
+
+    if(!readIntensityCurves(config))
+        return false;
+
+    return readPredictor(config);
+}
+
+bool WeightRetargetingCore::readActuatorsGroups(const yarp::os::Searchable& config)
+{
+    yarp::os::Bottle* actuatorGroupsBottle = config.find("actuator_groups").asList();
+    if(actuatorGroupsBottle==nullptr)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: actuator_groups";
+        return false;
+    }
+
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter: actuator_groups";
+    GroupParameters groupParameters;
+    for(size_t i=0; i<actuatorGroupsBottle->size(); i++)
+    {
+        yarp::os::Bottle* groupInfoBottle = actuatorGroupsBottle->get(i).asList();
+
+        if(groupInfoBottle==nullptr || groupInfoBottle->size()!=CONFIG_GROUP_SIZE)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The number of configuration parameter for group"<<i<<"is incorrect (must be"<<CONFIG_GROUP_SIZE<<")";
+            return false;
+        }
+
+        // get actuator group name
+        std::string groupName = groupInfoBottle->get(0).asString();
+        if(groupName=="all")
+        {
+            yCError(WEIGHT_RETARGETING_LOG_COMPONENT) << "All is a reserved name for actuator groups";
+            return false;
+        }
+        else if(groupIndexMap.find(groupName)!=groupIndexMap.end())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Multiple definition of actuator group"<<groupName;
+            return false;
+        }
+
+        //get axis names
+        std::vector<std::string> jointAxes;
+        yarp::os::Value& jointsList = groupInfoBottle->get(1);
+        if(jointsList.isList())
+        {
+            yarp::os::Bottle* jointsListBottle = jointsList.asList();
+            for(size_t i=0;i<jointsListBottle->size(); i++)
+            {
+                jointAxes.push_back(jointsListBottle->get(i).asString());
+            }
+        }
+        else
+        {
+            jointAxes.push_back(jointsList.asString());
+        }
+
+        //get min threshold
+        double minThreshold = groupInfoBottle->get(2).asFloat64();
+
+        //get max threshold
+        double maxThreshold = groupInfoBottle->get(3).asFloat64();
+
+        //get list of actuators
+        yarp::os::Bottle* actuatorListBottle = groupInfoBottle->get(4).asList();
+        if(actuatorListBottle==nullptr || actuatorListBottle->size()==0)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The actuators list of"<<groupName<<"is empty!";
+            return false;
+        }
+
+        for(size_t j = 0; j<actuatorListBottle->size(); j++) 
+            groups.actuators.push_back(IFEEL_SUIT_ACTUATOR_PREFIX+actuatorListBottle->get(j).asString());
+        groups.actuatorOffsets.push_back(groups.actuators.size());
+
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added actuator group: name"<<groupName//TODO axes  <<"| Joint axis"<<jointAxes
+                                                  <<"| Min threshold"<< minThreshold << "| Max threshold"<< maxThreshold;
+
+        //add joint axis name to the list, the weight is indexed once all of the joints are known
+        for(std::string& axisName : jointAxes)
+        {
+            if(axisName==WEIGHT_AXIS_NAME)
+            {
+                useWeight = true;
+                groups.jointIndexes.push_back(-1);
+                continue;
+            }
+
+            auto it = std::find(jointNames.begin(), jointNames.end(), axisName);
+            if(it==jointNames.end())
+            {
+                groups.jointIndexes.push_back(jointNames.size());
+                jointNames.push_back(axisName);
+            }
+            else
+            {
+                groups.jointIndexes.push_back(it - jointNames.begin());
+            }
+        }
+        groups.jointOffsets.push_back(groups.jointIndexes.size());
+        
+        // add group info to the table
+        groupIndexMap[groupName] = groups.size();
+        groups.names.push_back(groupName);
+        groupParameters.minThresholds.push_back(minThreshold);
+        groupParameters.maxThresholds.push_back(maxThreshold);
+        groupParameters.offsets.push_back(0.0);
+    }
+    parameters.initialize(groupParameters);
+    for(int& index : groups.jointIndexes)
+    {
+        if(index<0)
+            index = jointNames.size();
+    }
+    calibrationWindow.assign(groups.size()*calibrationSamples, 0.0);
+    calibrationEstimates.assign(groups.size(), 0.0);
+
+    // build the layout of the batch kernel
+    kernel.configure(groups.jointOffsets, groups.jointIndexes, getNumberOfValues(), RetargetingKernel::detectInstructionSet());
+    groupNorms.resize(groups.size());
+    intensities.resize(groups.size());
+
+    // no filter and no hysteresis by default
+    filters.assign(groups.size(), GroupFilter());
+    hysteresisBands.assign(groups.size(), 0.0);
+    groupActive.assign(groups.size(), false);
+    groupVelocityAllowed.assign(groups.size(), true);
+
+    // linear curves by default
+    curves.initialize(std::vector<IntensityCurve>(groups.size()));
+
+    // initialize the state of the delta output, all of the actuators are off
+    lastSentIntensities.assign(groups.actuators.size(), 0.0);
+    lastSentTimes.assign(groups.actuators.size(), 0.0);
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Using the" << RetargetingKernel::instructionSetToString(kernel.getInstructionSet()) << "kernel with"
+                                              << kernel.getNumberOfNorms() << "distinct norms for" << groups.size() << "groups";
+    
+    return true;
+}
+
+bool WeightRetargetingCore::readGroupFilters(const yarp::os::Searchable& config)
+{
+    if(!config.check("group_filters"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter group_filters, the groups are not filtered";
+        return true;
+    }
+
+    yarp::os::Bottle* groupFiltersBottle = config.find("group_filters").asList();
+    if(groupFiltersBottle==nullptr)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The parameter group_filters must be a list";
+        return false;
+    }
+
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter: group_filters";
+    for(size_t i=0; i<groupFiltersBottle->size(); i++)
+    {
+        yarp::os::Bottle* filterInfoBottle = groupFiltersBottle->get(i).asList();
+        if(filterInfoBottle==nullptr || filterInfoBottle->size()!=CONFIG_FILTER_SIZE)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The number of configuration parameter for filter"<<i<<"is incorrect (must be"<<CONFIG_FILTER_SIZE<<")";
+            return false;
+        }
+
+        // get the filtered groups
+        std::string groupName = filterInfoBottle->get(0).asString();
+        size_t firstGroup = 0;
+        size_t lastGroup = groups.size();
+        if(groupName!="all")
+        {
+            if(!getGroupIndex(groupName, firstGroup))
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Filter"<<i<<"refers to the unknown actuator group"<<groupName;
+                return false;
+            }
+            lastGroup = firstGroup+1;
+        }
+
+        std::string filterName = filterInfoBottle->get(1).asString();
+        double parameter = filterInfoBottle->get(2).asFloat64();
+
+        // the hysteresis acts on the on/off decision and can be combined with the other filters
+        if(filterName=="hysteresis")
+        {
+            if(parameter<0)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The hysteresis band of"<<groupName<<"must be non-negative";
+                return false;
+            }
+            for(size_t group=firstGroup; group<lastGroup; group++)
+                hysteresisBands[group] = parameter;
+        }
+        else
+        {
+            GroupFilter::Type type = GroupFilter::typeFromString(filterName);
+            if(type==GroupFilter::Type::Invalid)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid filter"<<filterName<<"for"<<groupName;
+                return false;
+            }
+            for(size_t group=firstGroup; group<lastGroup; group++)
+            {
+                if(!filters[group].configure(type, parameter))
+                {
+                    yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid parameter"<<parameter<<"of the filter"<<filterName<<"for"<<groupName;
+                    return false;
+                }
+            }
+        }
+
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added filter:"<<filterName<<"| Groups"<<groupName<<"| Parameter"<<parameter;
+    }
+
+    return true;
+}
+
+bool WeightRetargetingCore::readIntensityCurves(const yarp::os::Searchable& config)
+{
+    if(!config.check("group_curves"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter group_curves, the intensities are linear";
+        return true;
+    }
+
+    yarp::os::Bottle* groupCurvesBottle = config.find("group_curves").asList();
+    if(groupCurvesBottle==nullptr)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The parameter group_curves must be a list";
+        return false;
+    }
+
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter: group_curves";
+    for(size_t i=0; i<groupCurvesBottle->size(); i++)
+    {
+        yarp::os::Bottle* curveInfoBottle = groupCurvesBottle->get(i).asList();
+        if(curveInfoBottle==nullptr || curveInfoBottle->size()<CONFIG_CURVE_MIN_SIZE)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The number of configuration parameter for curve"<<i<<"is incorrect (must be at least"<<CONFIG_CURVE_MIN_SIZE<<")";
+            return false;
+        }
+
+        std::string groupName = curveInfoBottle->get(0).asString();
+        std::string curveName = curveInfoBottle->get(1).asString();
+        std::vector<double> curveParameters;
+        for(size_t j=CONFIG_CURVE_MIN_SIZE; j<curveInfoBottle->size(); j++)
+            curveParameters.push_back(curveInfoBottle->get(j).asFloat64());
+
+        if(!setIntensityCurve(groupName, curveName, curveParameters))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid curve"<<i<<"for"<<groupName;
+            return false;
+        }
+
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Added curve:"<<curveName<<"| Groups"<<groupName<<"| Parameters"<<curveParameters.size();
+    }
+
+    return true;
+}
+
+bool WeightRetargetingCore::readPredictor(const yarp::os::Searchable& config)
+{
+    predictors.assign(groups.size(), GroupPredictor());
+    predictedNorms.assign(groups.size(), 0.0);
+
+    // read predictor param
+    if(!config.check("predictor"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter predictor, the norms are not predicted";
+        return true;
+    }
+    std::string predictorName = config.find("predictor").asString();
+    predictorType = GroupPredictor::typeFromString(predictorName);
+    if(predictorType==GroupPredictor::Type::Invalid)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid predictor" << predictorName;
+        return false;
+    }
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter predictor:" << predictorName;
+    if(predictorType==GroupPredictor::Type::None)
+        return true;
+
+    // read prediction_horizon param
+    if(!config.check("prediction_horizon"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter prediction_horizon, using default value" << predictionHorizon;
+    } else
+    {
+        predictionHorizon = config.find("prediction_horizon").asFloat64();
+        if(predictionHorizon<0)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The parameter prediction_horizon must be non-negative";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter prediction_horizon:" << predictionHorizon;
+    }
+
+    if(predictorType==GroupPredictor::Type::Linear)
+    {
+        // read prediction_window param
+        if(!config.check("prediction_window"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter prediction_window, using default value" << predictionWindow;
+        } else
+        {
+            predictionWindow = config.find("prediction_window").asInt32();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter prediction_window:" << predictionWindow;
+        }
+    }
+    else
+    {
+        // read prediction_process_noise and prediction_measurement_noise params
+        if(!config.check("prediction_process_noise"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter prediction_process_noise, using default value" << predictionProcessNoise;
+        } else
+        {
+            predictionProcessNoise = config.find("prediction_process_noise").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter prediction_process_noise:" << predictionProcessNoise;
+        }
+        if(!config.check("prediction_measurement_noise"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter prediction_measurement_noise, using default value" << predictionMeasurementNoise;
+        } else
+        {
+            predictionMeasurementNoise = config.find("prediction_measurement_noise").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter prediction_measurement_noise:" << predictionMeasurementNoise;
+        }
+    }
+
+    for(GroupPredictor& predictor : predictors)
+    {
+        bool result = predictorType==GroupPredictor::Type::Linear ? predictor.configureLinear(predictionWindow)
+                                                                  : predictor.configureKalman(predictionProcessNoise, predictionMeasurementNoise);
+        if(!result)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid parameters of the predictor" << predictorName;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void WeightRetargetingCore::generateGroupsActuation(const std::vector<double>& interfaceValues, const std::vector<double>& velocities, const double time, std::vector<ActuationCommand>& commands)
+{
+    generateGroupsActuation(interfaceValues, velocities, time, time, commands);
+}
+
+void WeightRetargetingCore::generateGroupsActuation(const std::vector<double>& interfaceValues, const std::vector<double>& velocities, const double time, const double measurementTime, std::vector<ActuationCommand>& commands)
+{
+    // compute and filter the norms, with the stages specialized for the layout of the groups if available
+    if(specializedStages.computeNorms!=nullptr)
+        specializedStages.computeNorms(interfaceValues.data(), groupNorms.data());
+    else
+        kernel.computeNorms(interfaceValues.data(), groupNorms.data());
+    for(size_t group=0; group<groups.size(); group++)
+        groupNorms[group] = filters[group].apply(groupNorms[group]);
+
+    // collect the filtered norms for the offset calibration
+    updateCalibration(groupNorms, time);
+
+    // predict the norms when the commands will be actuated, the lead is capped so that a stale sample is not extrapolated too far
+    const double* actuatedNorms = groupNorms.data();
+    if(predictorType!=GroupPredictor::Type::None)
+    {
+        predictionLead = std::min(predictionHorizon + std::max(time-measurementTime, 0.0), 2.0*predictionHorizon);
+        for(size_t group=0; group<groups.size(); group++)
+            predictedNorms[group] = predictors[group].apply(groupNorms[group], measurementTime, predictionLead);
+        actuatedNorms = predictedNorms.data();
+    }
+
+    // compute the intensities with a consistent snapshot of the parameters
+    const GroupParameters& groupParameters = parameters.acquire();
+    kernel.computeIntensities(actuatedNorms, groupParameters.offsets.data(), groupParameters.minThresholds.data(), groupParameters.maxThresholds.data(), intensities.data());
+
+    // the groups with a nonlinear curve are mapped through its lookup table
+    const std::vector<IntensityCurve>& groupCurves = curves.acquire();
+    for(size_t group=0; group<groups.size(); group++)
+    {
+        if(groupCurves[group].getType()!=IntensityCurve::Type::Linear)
+            intensities[group] = groupCurves[group].map(actuatedNorms[group]+groupParameters.offsets[group], groupParameters.minThresholds[group], groupParameters.maxThresholds[group]);
+    }
+    curves.release();
+    parameters.release();
+
+    //check groups velocity
+    if(specializedStages.checkVelocities!=nullptr)
+    {
+        specializedStages.checkVelocities(velocities.data(), maxJointVelocity, groupVelocityAllowed);
+    }
+    else
+    {
+        for(size_t group=0; group<groups.size(); group++)
+            groupVelocityAllowed[group] = !useVelocities || checkGroupVelocity(group, velocities);
+    }
+
+    commands.clear();
+    for(size_t group=0; group<groups.size(); group++)
+    {
+        bool active = groupVelocityAllowed[group];
+
+        // the threshold of the on/off decision depends on the current state of the group
+        double actuationIntensity = intensities[group];
+        const double threshold = groupActive[group] ? minIntensity-hysteresisBands[group] : minIntensity+hysteresisBands[group];
+        active = active && actuationIntensity>threshold;
+        groupActive[group] = active;
+        if(!deltaOutput)
+        {
+            if(!active)
+                continue;
+
+            // generate the command for all the related actuators
+            for(int i=groups.actuatorOffsets[group]; i<groups.actuatorOffsets[group+1]; i++)
+            {
+                commands.push_back({&groups.actuators[i], actuationIntensity});
+            }
+            continue;
+        }
+
+        // generate the command only for the actuators whose intensity has changed or has to be kept alive
+        if(!active)
+            actuationIntensity = 0.0;
+
+        for(int i=groups.actuatorOffsets[group]; i<groups.actuatorOffsets[group+1]; i++)
+        {
+            bool changed = actuationIntensity!=lastSentIntensities[i];
+            bool keepAlive = active && time-lastSentTimes[i]>=keepAlivePeriod;
+            if(changed || keepAlive)
+            {
+                commands.push_back({&groups.actuators[i], actuationIntensity});
+                lastSentIntensities[i] = actuationIntensity;
+                lastSentTimes[i] = time;
+            }
+            else if(active)
+            {
+                suppressedCommands++;
+            }
+        }
+    }
+}
+
+bool WeightRetargetingCore::setMaxThreshold(const std::string& actuatorGroup, const double value)
+{
+    size_t group;
+    if(!getGroupIndex(actuatorGroup, group))
+        return false;
+
+    return parameters.update([&](GroupParameters& groupParameters)
+    {
+        groupParameters.maxThresholds[group] = value;
+        return true;
+    });
+}
+
+bool WeightRetargetingCore::setMinThreshold(const std::string& actuatorGroup, const double value)
+{
+    size_t group;
+    if(!getGroupIndex(actuatorGroup, group))
+        return false;
+
+    return parameters.update([&](GroupParameters& groupParameters)
+    {
+        groupParameters.minThresholds[group] = value;
+        return true;
+    });
+}
+
+bool WeightRetargetingCore::setThresholds(const std::string& actuatorGroup, const double minThreshold, const double maxThreshold)
+{
+    size_t group;
+    if(!getGroupIndex(actuatorGroup, group))
+        return false;
+
+    return parameters.update([&](GroupParameters& groupParameters)
+    {
+        groupParameters.minThresholds[group] = minThreshold;
+        groupParameters.maxThresholds[group] = maxThreshold;
+        return true;
+    });
+}
+
+bool WeightRetargetingCore::setIntensityCurve(const std::string& actuatorGroup, const std::string& curveName, const std::vector<double>& curveParameters)
+{
+    size_t firstGroup = 0;
+    size_t lastGroup = groups.size();
+    if(actuatorGroup!="all")
+    {
+        if(!getGroupIndex(actuatorGroup, firstGroup))
+            return false;
+        lastGroup = firstGroup+1;
+    }
+
+    // the lookup table is compiled before publishing, so that the control cycle only switches to it
+    IntensityCurve curve;
+    if(!curve.configure(IntensityCurve::typeFromString(curveName), curveParameters))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Invalid parameters of the curve"<<curveName;
+        return false;
+    }
+
+    return curves.update([&](std::vector<IntensityCurve>& groupCurves)
+    {
+        for(size_t group=firstGroup; group<lastGroup; group++)
+            groupCurves[group] = curve;
+        return true;
+    });
+}
+
+bool WeightRetargetingCore::removeOffset(const std::string& actuatorGroup)
+{
+    size_t group = 0;
+    if(actuatorGroup!="all" && !getGroupIndex(actuatorGroup, group))
+        return false;
+
+    // the request is written before the state, so that the control cycle reads it only once it is complete
+    CalibrationState expected = CalibrationState::Idle;
+    if(calibrationState.load()!=expected)
+        return false;
+    calibrationRequestedGroup = actuatorGroup=="all" ? -1 : static_cast<int>(group);
+    return calibrationState.compare_exchange_strong(expected, CalibrationState::Requested);
+}
+
+void WeightRetargetingCore::updateCalibration(const std::vector<double>& norms, const double time)
+{
+    CalibrationState state = calibrationState.load();
+    if(state==CalibrationState::Idle)
+        return;
+
+    if(state==CalibrationState::Requested)
+    {
+        // take the request and start the window
+        calibrationGroup = calibrationRequestedGroup;
+        calibrationStartTime = time;
+        calibrationCollectedSamples = 0;
+        state = CalibrationState::Collecting;
+        calibrationState = state;
+    }
+
+    const size_t firstGroup = calibrationGroup<0 ? 0 : calibrationGroup;
+    const size_t lastGroup = calibrationGroup<0 ? groups.size() : calibrationGroup+1;
+    if(state==CalibrationState::Collecting)
+    {
+        const int sample = calibrationCollectedSamples;
+        for(size_t group=firstGroup; group<lastGroup; group++)
+            calibrationWindow[group*calibrationSamples+sample] = norms[group];
+        calibrationCollectedSamples = sample+1;
+
+        // the window ends when it is full or, if a duration is set, when it expires
+        bool expired = calibrationDuration>0 && time-calibrationStartTime>=calibrationDuration;
+        if(sample+1<calibrationSamples && !expired)
+            return;
+
+        for(size_t group=firstGroup; group<lastGroup; group++)
+            calibrationEstimates[group] = estimateBaseline(&calibrationWindow[group*calibrationSamples], sample+1);
+        state = CalibrationState::Committing;
+        calibrationState = state;
+    }
+
+    // publish the offsets only if no RPC is updating the parameters, so that the control cycle never waits
+    bool published = parameters.tryUpdate([&](GroupParameters& groupParameters)
+    {
+        for(size_t group=firstGroup; group<lastGroup; group++)
+            groupParameters.offsets[group] = groupParameters.minThresholds[group] - calibrationEstimates[group];
+        return true;
+    });
+    if(published)
+        calibrationState = CalibrationState::Idle;
+}
+
+double WeightRetargetingCore::estimateBaseline(double* samples, const size_t size) const
+{
+    if(calibrationEstimator==CalibrationEstimator::Mean)
+    {
+        double sum = 0.0;
+        for(size_t i=0; i<size; i++)
+            sum += samples[i];
+        return sum/size;
+    }
+
+    // median, the average of the two central samples if their number is even
+    double* middle = samples+size/2;
+    std::nth_element(samples, middle, samples+size);
+    if(size%2==1)
+        return *middle;
+    return 0.5*(*std::max_element(samples, middle) + *middle);
+}
+
+bool WeightDisplayCore::configure(const yarp::os::Searchable& config)
+{
+    // read input port names
+    yarp::os::Bottle* inputPortNamesBottle = config.find("input_port_names").asList();
+    if(inputPortNamesBottle == nullptr)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter input_port_names!";
+        return false;
+    }
+    else if(inputPortNamesBottle->size()==0)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter input_port_names is empty!";
+        return false;
+    }
+
+    for(size_t i=0; i<inputPortNamesBottle->size(); i++)
+    {
+        std::string portName = inputPortNamesBottle->get(i).asString();
+        if(portName=="all")
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "All is a reserved name for the inputs";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found input port name:"<<portName;
+        inputNames.push_back(portName);
+    }
+    inputJoints.resize(inputNames.size());
+
+    // read min_weight
+    DisplayParameters displayParameters;
+    if(!config.check("min_weight"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter min_weight, using default value:"<<displayParameters.minWeight;
+    } else
+    {
+        displayParameters.minWeight = config.find("min_weight").asFloat64();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter min_weight:" << displayParameters.minWeight;
+    }
+    displayParameters.offsets.assign(inputNames.size(), Wrench{});
+    parameters.initialize(displayParameters);
+
+    // read tare_samples
+    if(!config.check("tare_samples"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter tare_samples, using default value:"<<tareSamples;
+    } else
+    {
+        tareSamples = config.find("tare_samples").asInt32();
+        if(tareSamples<1)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter tare_samples must be positive";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter tare_samples:" << tareSamples;
+    }
+
+    // read tare_max_deviation
+    if(!config.check("tare_max_deviation"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter tare_max_deviation, using default value:"<<tareMaxDeviation;
+    } else
+    {
+        tareMaxDeviation = config.find("tare_max_deviation").asFloat64();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter tare_max_deviation:" << tareMaxDeviation;
+    }
+    // read tare_timeout
+    if(!config.check("tare_timeout"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter tare_timeout, using default value:"<<tareTimeout;
+    } else
+    {
+        tareTimeout = config.find("tare_timeout").asFloat64();
+        if(tareTimeout<=0)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter tare_timeout must be positive";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter tare_timeout:" << tareTimeout;
+    }
+    tareCounts.assign(inputNames.size(), 0);
+    tareSums.assign(inputNames.size(), Wrench{});
+    tareSquareSums.assign(inputNames.size(), Wrench{});
+    tareSampleTimes.assign(inputNames.size(), 0.0);
+    tareMeans.assign(inputNames.size(), Wrench{});
+
+    yarp::os::Bottle velocityUtilsGroup = config.findGroup("VELOCITY_UTILS");
+    if(velocityUtilsGroup.isNull())
+    {
+        // use default
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Group VELOCITY_UTILS not found, velocity information will not be used";
+        return true; 
+    }
+
+    // read use_velocity 
+    if(!velocityUtilsGroup.check("use_velocity"))
+    {
+        // use default
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter use_velocity. Using default value:"<<useVelocity;
+        return true;
+    }
+    useVelocity = velocityUtilsGroup.find("use_velocity").asBool();
+    yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter use_velocity is:"<<useVelocity;
+
+    if(!useVelocity)
+    {
+        return true;
+    }
+
+    // read max_velocity
+    if(!velocityUtilsGroup.check("max_velocity"))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter max_velocity when use_velocity is enabled";
+        return false;
+    }
+    maxVelocity = velocityUtilsGroup.find("max_velocity").asFloat64();
+
+    // read joints_info
+    if(!velocityUtilsGroup.check("joints_info"))
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter joints_info when use_velocity is enabled";
+        return false;
+    }
+    yarp::os::Bottle* jointsInfoBottle = velocityUtilsGroup.find("joints_info").asList();
+    if(jointsInfoBottle->size()==0)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter joints_info cannot be an empty list!";
+        return false;
+    }
+    for(size_t i=0;i<jointsInfoBottle->size();i++)
+    {
+        yarp::os::Bottle* infoBottle = jointsInfoBottle->get(i).asList(); 
+        if(infoBottle->size()<2)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Bad joints_info format!";
+            return false;
+        }
+
+        // read joint axes
+        std::vector<int> jointsIndices = {};
+        for(size_t j=1; j<infoBottle->size(); j++)
+        {
+            jointsIndices.push_back(jointAxes.size());
+            jointAxes.push_back(infoBottle->get(j).asString());
+        }
+
+        // link the joints to the related input
+        auto it = std::find(inputNames.begin(), inputNames.end(), infoBottle->get(0).asString());
+        if(it!=inputNames.end())
+            inputJoints[it-inputNames.begin()] = jointsIndices;
+    }
+
+    return true;
+}
+
+bool WeightDisplayCore::getInputIndex(const std::string& input, size_t& index) const
+{
+    auto it = std::find(inputNames.begin(), inputNames.end(), input);
+    if(it==inputNames.end())
+        return false;
+
+    index = it - inputNames.begin();
+    return true;
+}
+
+double WeightDisplayCore::removeOffsets(std::vector<const double*>& wrenches, std::vector<Wrench>& compensatedWrenches)
+{
+    const DisplayParameters& displayParameters = parameters.acquire();
+    for(size_t i=0; i<wrenches.size(); i++)
+    {
+        if(wrenches[i]==nullptr)
+            continue;
+
+        for(size_t j=0; j<compensatedWrenches[i].size(); j++)
+            compensatedWrenches[i][j] = wrenches[i][j] - displayParameters.offsets[i][j];
+        wrenches[i] = compensatedWrenches[i].data();
+    }
+    const double minWeight = displayParameters.minWeight;
+    parameters.release();
+
+    return minWeight;
+}
+
+std::string WeightDisplayCore::tareStateToString(const TareState state)
+{
+    switch(state)
+    {
+    case TareState::Idle: return "idle";
+    case TareState::Requested: return "requested";
+    case TareState::Collecting: return "collecting";
+    case TareState::Committing: return "committing";
+    default: return "invalid";
+    }
+}
+
+std::string WeightDisplayCore::tareResultToString(const TareResult result)
+{
+    switch(result)
+    {
+    case TareResult::None: return "none";
+    case TareResult::Succeeded: return "succeeded";
+    case TareResult::Rejected: return "rejected";
+    case TareResult::TimedOut: return "timed_out";
+    default: return "invalid";
+    }
+}
+
+bool WeightDisplayCore::requestTare(const std::string& input)
+{
+    size_t index = 0;
+    if(input!="all" && !getInputIndex(input, index))
+        return false;
+
+    // the request is written before the state, so that the tick reads it only once it is complete
+    TareState expected = TareState::Idle;
+    if(tareState.load()!=expected)
+        return false;
+    tareRequestedInput = input=="all" ? -1 : static_cast<int>(index);
+    return tareState.compare_exchange_strong(expected, TareState::Requested);
+}
+
+void WeightDisplayCore::updateTare(const std::vector<const double*>& wrenches, const std::vector<double>& wrenchTimes, const double time)
+{
+    TareState state = tareState.load();
+    if(state==TareState::Idle)
+        return;
+
+    if(state==TareState::Requested)
+    {
+        // take the request and reset the statistics
+        tareInput = tareRequestedInput;
+        tareStartTime = time;
+        tareCollectedSamples = 0;
+        tareResult = TareResult::None;
+        std::fill(tareCounts.begin(), tareCounts.end(), 0);
+        std::fill(tareSums.begin(), tareSums.end(), Wrench{});
+        std::fill(tareSquareSums.begin(), tareSquareSums.end(), Wrench{});
+        std::fill(tareSampleTimes.begin(), tareSampleTimes.end(), -std::numeric_limits<double>::infinity());
+        state = TareState::Collecting;
+        tareState = state;
+    }
+
+    if(state==TareState::Collecting)
+    {
+        int collectedSamples = tareSamples;
+        for(size_t i=0; i<wrenches.size(); i++)
+        {
+            if(tareInput>=0 && static_cast<int>(i)!=tareInput)
+                continue;
+
+            if(wrenches[i]!=nullptr && wrenchTimes[i]>tareSampleTimes[i] && tareCounts[i]<tareSamples)
+            {
+                tareSampleTimes[i] = wrenchTimes[i];
+                for(size_t j=0; j<tareSums[i].size(); j++)
+                {
+                    tareSums[i][j] += wrenches[i][j];
+                    tareSquareSums[i][j] += wrenches[i][j]*wrenches[i][j];
+                }
+                tareCounts[i]++;
+            }
+            collectedSamples = std::min(collectedSamples, tareCounts[i]);
+        }
+        tareCollectedSamples = collectedSamples;
+
+        if(collectedSamples<tareSamples)
+        {
+            if(time-tareStartTime>tareTimeout)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Tare timed out: not enough wrenches received";
+                tareResult = TareResult::TimedOut;
+                tareState = TareState::Idle;
+            }
+            return;
+        }
+
+        // compute the mean of the samples and check the deviation of the force
+        bool valid = true;
+        for(size_t i=0; i<inputNames.size(); i++)
+        {
+            if(tareInput>=0 && static_cast<int>(i)!=tareInput)
+                continue;
+
+            double forceVariance = 0.0;
+            for(size_t j=0; j<tareMeans[i].size(); j++)
+            {
+                tareMeans[i][j] = tareSums[i][j]/tareCounts[i];
+                if(j<3)
+                    forceVariance += std::max(0.0, tareSquareSums[i][j]/tareCounts[i] - tareMeans[i][j]*tareMeans[i][j]);
+            }
+            double forceDeviation = std::sqrt(forceVariance);
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Tare of" << inputNames[i] << ": force offset" << tareMeans[i][0] << tareMeans[i][1] << tareMeans[i][2]
+                                                      << "| standard deviation" << forceDeviation << "over" << tareCounts[i] << "samples";
+            if(tareMaxDeviation>0 && forceDeviation>tareMaxDeviation)
+            {
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The force of" << inputNames[i] << "is not steady enough for the tare";
+                valid = false;
+            }
+        }
+
+        if(!valid)
+        {
+            tareResult = TareResult::Rejected;
+            tareState = TareState::Idle;
+            return;
+        }
+        state = TareState::Committing;
+        tareState = state;
+    }
+
+    // publish the offsets only if no RPC is updating the parameters, so that the tick never waits
+    bool published = parameters.tryUpdate([&](DisplayParameters& displayParameters)
+    {
+        for(size_t i=0; i<inputNames.size(); i++)
+        {
+            if(tareInput<0 || static_cast<int>(i)==tareInput)
+                displayParameters.offsets[i] = tareMeans[i];
+        }
+        return true;
+    });
+    if(published)
+    {
+        tareResult = TareResult::Succeeded;
+        tareState = TareState::Idle;
+    }
+}
+
+bool WeightDisplayCore::clearTare(const std::string& input)
+{
+    size_t index = 0;
+    if(input!="all" && !getInputIndex(input, index))
+        return false;
+
+    return parameters.update([&](DisplayParameters& displayParameters)
+    {
+        for(size_t i=0; i<inputNames.size(); i++)
+        {
+            if(input=="all" || i==index)
+                displayParameters.offsets[i] = Wrench{};
+        }
+        return true;
+    });
+}
+
+bool WeightDisplayCore::setMinWeight(const double value)
+{
+    return parameters.update([&](DisplayParameters& displayParameters)
+    {
+        displayParameters.minWeight = value;
+        return true;
+    });
+}
+
+bool WeightDisplayCore::checkInputVelocity(const size_t input, const std::vector<double>& velocities) const
+{
+    for(const int &index : inputJoints[input])
+    {
+        if(velocities[index]>maxVelocity)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool WeightDisplayCore::orientationToRotation(const double* orientation, const size_t size, double* rotation)
+{
+    if(size==9)
+    {
+        std::copy(orientation, orientation+9, rotation);
+        return true;
+    }
+
+    if(size!=4)
+        return false;
+
+    // normalize the quaternion, so that the rotation matrix is orthonormal
+    double norm = std::sqrt(orientation[0]*orientation[0] + orientation[1]*orientation[1] + orientation[2]*orientation[2] + orientation[3]*orientation[3]);
+    if(norm==0)
+        return false;
+    const double w = orientation[0]/norm;
+    const double x = orientation[1]/norm;
+    const double y = orientation[2]/norm;
+    const double z = orientation[3]/norm;
+
+    rotation[0] = 1-2*(y*y+z*z); rotation[1] = 2*(x*y-w*z);   rotation[2] = 2*(x*z+w*y);
+    rotation[3] = 2*(x*y+w*z);   rotation[4] = 1-2*(x*x+z*z); rotation[5] = 2*(y*z-w*x);
+    rotation[6] = 2*(x*z-w*y);   rotation[7] = 2*(y*z+w*x);   rotation[8] = 1-2*(x*x+y*y);
+    return true;
+}
+
+void WeightDisplayCore::rotateWrenches(const std::vector<const double*>& rotations, std::vector<const double*>& wrenches, std::vector<Wrench>& rotatedWrenches)
+{
+    for(size_t i=0; i<wrenches.size(); i++)
+    {
+        if(wrenches[i]==nullptr || rotations[i]==nullptr)
+        {
+            wrenches[i] = nullptr;
+            continue;
+        }
+
+        rotateWrench(rotations[i], wrenches[i], rotatedWrenches[i].data());
+        wrenches[i] = rotatedWrenches[i].data();
+    }
+}
+
+double WeightDisplayCore::computeWeight(const std::vector<const double*>& wrenches, const std::vector<double>& velocities) const
+{
+    // sum z-axis forces
+    double zForce = 0.0;
+    for(size_t i=0; i<wrenches.size(); i++)
+    {
+        // add the force if available and if the velocity check is passed
+        if(wrenches[i]==nullptr || (useVelocity && !checkInputVelocity(i, velocities)))
+            continue;
+
+        if(wrenches[i][2]<0)
+            zForce += -wrenches[i][2];
+    }
+
+    // calculate weight
+    return zForce/GRAVITY_ACCELERATION;
+}
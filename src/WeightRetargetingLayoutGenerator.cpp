@@ -0,0 +1,125 @@
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/LogStream.h>
+
+#include "WeightRetargetingCore.h"
+#include "WeightRetargetingLogComponent.h"
+
+/**
+ * @brief Generates at build time the layout of the actuator groups of a configuration file,
+ * used by RetargetingPipeline to specialize the control cycle for that layout.
+ * The groups are read by WeightRetargetingCore, so the layout is the same that the module reads at runtime.
+ *
+ * Usage: WeightRetargetingLayoutGenerator --from <config.ini> --name <layout> --output <header>
+ */
+class WeightRetargetingLayoutGenerator
+{
+public:
+
+    const std::string LOG_PREFIX = "LayoutGenerator";
+
+    /**
+     * @brief Get a valid C++ identifier from the name of a layout
+     *
+     * @param name the name of the layout
+     * @return std::string the name with the invalid characters replaced by underscores
+     */
+    static std::string toIdentifier(const std::string& name)
+    {
+        std::string identifier;
+        for(const char c : name)
+            identifier += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+        if(identifier.empty() || std::isdigit(static_cast<unsigned char>(identifier[0])))
+            identifier = "_"+identifier;
+        return identifier;
+    }
+
+    /**
+     * @brief Write the header of the layout of a configured core
+     *
+     * @param core the configured core
+     * @param name the name of the layout
+     * @param path the path of the header
+     * @return true if the header has been written
+     * @return false otherwise
+     */
+    bool writeLayout(const WeightRetargetingCore& core, const std::string& name, const std::string& path)
+    {
+        std::ofstream file(path);
+        if(!file)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to write" << path;
+            return false;
+        }
+
+        const std::string identifier = toIdentifier(name);
+        const std::string guard = "WEIGHT_RETARGETING_LAYOUT_" + identifier + "_H";
+        file << "// Generated by WeightRetargetingLayoutGenerator, do not edit\n\n";
+        file << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+        file << "#include \"RetargetingPipeline.h\"\n\n";
+        file << "struct " << identifier << "Layout\n{\n";
+        file << "    static const char* getName() { return \"" << name << "\"; }\n\n";
+        file << "    static constexpr size_t NUMBER_OF_JOINTS = " << core.jointNames.size() << ";\n\n";
+        file << "    static const char* getJointName(const size_t joint)\n    {\n";
+        file << "        static const char* const JOINT_NAMES[] = {";
+        for(const std::string& jointName : core.jointNames)
+            file << "\"" << jointName << "\", ";
+        file << "nullptr};\n";
+        file << "        return JOINT_NAMES[joint];\n    }\n\n";
+
+        // one group for each line, in the order of the configuration
+        file << "    using Groups = RetargetingGroupList<";
+        for(size_t group=0; group<core.groups.size(); group++)
+        {
+            file << "\n        RetargetingGroup<";
+            for(int i=core.groups.jointOffsets[group]; i<core.groups.jointOffsets[group+1]; i++)
+                file << (i>core.groups.jointOffsets[group] ? ", " : "") << core.groups.jointIndexes[i];
+            file << ">" << (group+1<core.groups.size() ? "," : "") << " // " << core.groups.names[group];
+        }
+        file << "\n    >;\n};\n\n";
+        file << "#endif // " << guard << "\n";
+
+        if(!file)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to write" << path;
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Generated the layout" << name << "with" << core.groups.size() << "groups in" << path;
+        return true;
+    }
+
+    int run(yarp::os::ResourceFinder& rf)
+    {
+        if(!rf.check("name") || !rf.check("output"))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: name or output";
+            return EXIT_FAILURE;
+        }
+
+        WeightRetargetingCore core;
+        if(!core.configure(rf))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to read the actuator groups";
+            return EXIT_FAILURE;
+        }
+
+        if(!writeLayout(core, rf.find("name").asString(), rf.find("output").asString()))
+            return EXIT_FAILURE;
+
+        return EXIT_SUCCESS;
+    }
+};
+
+int main(int argc, char * argv[])
+{
+    // the generator does not use the YARP network
+    yarp::os::ResourceFinder rf;
+    rf.configure(argc, argv);
+
+    WeightRetargetingLayoutGenerator generator;
+    return generator.run(rf);
+}
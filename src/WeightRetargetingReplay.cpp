@@ -0,0 +1,326 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <yarp/os/ResourceFinder.h>
+#include <yarp/os/LogStream.h>
+
+#include "RetargetingLayouts.h"
+#include "TickRecording.h"
+#include "WeightRetargetingCore.h"
+#include "WeightRetargetingLogComponent.h"
+
+/**
+ * @brief Replays a tick recording through the retargeting core, without the YARP network.
+ * It reports the number of ticks per second, writes the generated output log and compares it with a golden log.
+ * The retargeting uses the control cycle specialized for its layout, if any, unless --generic is given.
+ *
+ * If the predictor of the norms is enabled, its accuracy is measured against the norms replayed at the predicted time.
+ *
+ * Usage: WeightRetargetingReplay --from <config.ini> --recording <file> [--output <log>] [--golden <log>] [--generic] [--check_prediction]
+ */
+class WeightRetargetingReplay
+{
+public:
+
+    const std::string LOG_PREFIX = "Replay";
+
+    // Command generated in a tick of a retargeting recording
+    struct OutputCommand
+    {
+        size_t tick;
+        const std::string* actuator;
+        double intensity;
+    };
+
+    TickRecording recording;
+    std::vector<std::string> outputLines;
+
+    /**
+     * @brief Replay a recording of the WeightRetargetingModule
+     *
+     * @param config the configuration of the module
+     * @return true if the configuration matches the recording and, with check_prediction, if the predictor is accurate
+     * @return false otherwise
+     */
+    bool replayRetargeting(const yarp::os::Searchable& config)
+    {
+        WeightRetargetingCore core;
+        if(!core.configure(config))
+            return false;
+
+        if(!config.check("generic") && selectSpecializedStages(core))
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Replaying with the control cycle specialized for the layout" << core.specializedStages.layout;
+        else
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Replaying with the generic control cycle";
+
+        const TickRecordingHeader& header = recording.getHeader();
+        // the weight, if retargeted, is recorded after the joints
+        if(header.numberOfValues!=core.getNumberOfValues() || header.numberOfVelocities!=core.getNumberOfValues())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The recording has" << header.numberOfValues << "values, the configuration has" << core.getNumberOfValues();
+            return false;
+        }
+
+        // the buffers are allocated before the replay, so that only the core is measured
+        std::vector<double> interfaceValues(header.numberOfValues);
+        std::vector<double> velocities(header.numberOfVelocities);
+        std::vector<WeightRetargetingCore::ActuationCommand> commands;
+        commands.reserve(core.groups.actuators.size());
+        std::vector<OutputCommand> outputCommands;
+        outputCommands.reserve(recording.size()*core.groups.actuators.size());
+
+        // the filtered and the predicted norms of each tick are kept to measure the accuracy of the predictor
+        const bool predictionEnabled = core.predictorType!=GroupPredictor::Type::None;
+        const size_t numberOfGroups = core.groups.size();
+        std::vector<double> norms(predictionEnabled ? recording.size()*numberOfGroups : 0);
+        std::vector<double> predictedNorms(norms.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for(size_t tick=0; tick<recording.size(); tick++)
+        {
+            std::copy(recording.getValues(tick), recording.getValues(tick)+header.numberOfValues, interfaceValues.begin());
+            std::copy(recording.getVelocities(tick), recording.getVelocities(tick)+header.numberOfVelocities, velocities.begin());
+            core.generateGroupsActuation(interfaceValues, velocities, recording.getTime(tick), commands);
+            for(const WeightRetargetingCore::ActuationCommand& command : commands)
+                outputCommands.push_back({tick, command.actuator, command.intensity});
+            if(predictionEnabled)
+            {
+                std::copy(core.groupNorms.begin(), core.groupNorms.end(), norms.begin()+tick*numberOfGroups);
+                std::copy(core.predictedNorms.begin(), core.predictedNorms.end(), predictedNorms.begin()+tick*numberOfGroups);
+            }
+        }
+        reportRate(std::chrono::steady_clock::now()-start);
+
+        if(predictionEnabled && !evaluatePrediction(numberOfGroups, core.predictionLead, norms, predictedNorms) && config.check("check_prediction"))
+            return false;
+
+        // one line for each command: <tick> <actuator> <intensity>
+        char line[256];
+        outputLines.reserve(outputCommands.size());
+        for(const OutputCommand& command : outputCommands)
+        {
+            std::snprintf(line, sizeof(line), "%zu %s %.17g", command.tick, command.actuator->c_str(), command.intensity);
+            outputLines.push_back(line);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Replay a recording of the WeightDisplayModule
+     *
+     * @param config the configuration of the module
+     * @return true if the configuration matches the recording
+     * @return false otherwise
+     */
+    bool replayDisplay(const yarp::os::Searchable& config)
+    {
+        WeightDisplayCore core;
+        if(!core.configure(config))
+            return false;
+
+        const TickRecordingHeader& header = recording.getHeader();
+        const size_t numberOfVelocities = core.useVelocity ? core.jointAxes.size() : 0;
+        if(header.numberOfValues!=core.inputNames.size()*TickRecordingHeader::WRENCH_SIZE || header.numberOfVelocities!=numberOfVelocities)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The size of the recording does not match the inputs of the configuration";
+            return false;
+        }
+
+        std::vector<const double*> wrenches(core.inputNames.size());
+        std::vector<double> velocities(header.numberOfVelocities);
+        std::vector<double> weights(recording.size());
+
+        auto start = std::chrono::steady_clock::now();
+        for(size_t tick=0; tick<recording.size(); tick++)
+        {
+            // the wrenches not available are recorded as NaN
+            const double* values = recording.getValues(tick);
+            for(size_t i=0; i<wrenches.size(); i++)
+            {
+                const double* wrench = values+i*TickRecordingHeader::WRENCH_SIZE;
+                wrenches[i] = std::isnan(wrench[0]) ? nullptr : wrench;
+            }
+            std::copy(recording.getVelocities(tick), recording.getVelocities(tick)+header.numberOfVelocities, velocities.begin());
+            weights[tick] = core.computeWeight(wrenches, velocities);
+        }
+        reportRate(std::chrono::steady_clock::now()-start);
+
+        // one line for each tick: <tick> <weight>
+        char line[64];
+        outputLines.reserve(weights.size());
+        for(size_t tick=0; tick<weights.size(); tick++)
+        {
+            std::snprintf(line, sizeof(line), "%zu %.17g", tick, weights[tick]);
+            outputLines.push_back(line);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Compare the predicted norms with the norms replayed at the predicted time, interpolated between the enclosing ticks,
+     * and with the norms used without the predictor. The recording gives the timestamps of the samples, so the lead is the horizon.
+     *
+     * @param numberOfGroups the number of actuator groups
+     * @param lead the time ahead of each tick of the predictions
+     * @param norms the filtered norms of the groups for each tick
+     * @param predictedNorms the predicted norms of the groups for each tick
+     * @return true if the predicted norms are closer to the future norms than the current ones
+     * @return false otherwise
+     */
+    bool evaluatePrediction(const size_t numberOfGroups, const double lead, const std::vector<double>& norms, const std::vector<double>& predictedNorms)
+    {
+        double predictionError = 0.0;
+        double holdError = 0.0;
+        size_t count = 0;
+        size_t after = 0;
+        for(size_t tick=0; tick<recording.size(); tick++)
+        {
+            const double target = recording.getTime(tick)+lead;
+            while(after<recording.size() && recording.getTime(after)<target)
+                after++;
+            if(after==recording.size())
+                break;
+
+            const size_t before = after>0 ? after-1 : 0;
+            const double beforeTime = recording.getTime(before);
+            const double afterTime = recording.getTime(after);
+            const double ratio = afterTime>beforeTime ? (target-beforeTime)/(afterTime-beforeTime) : 1.0;
+            for(size_t group=0; group<numberOfGroups; group++)
+            {
+                const double beforeNorm = norms[before*numberOfGroups+group];
+                const double futureNorm = beforeNorm + ratio*(norms[after*numberOfGroups+group]-beforeNorm);
+                const double predictionDifference = predictedNorms[tick*numberOfGroups+group]-futureNorm;
+                const double holdDifference = norms[tick*numberOfGroups+group]-futureNorm;
+                predictionError += predictionDifference*predictionDifference;
+                holdError += holdDifference*holdDifference;
+                count++;
+            }
+        }
+
+        if(count==0)
+        {
+            yCIWarning(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The recording is shorter than the prediction horizon";
+            return true;
+        }
+
+        predictionError = std::sqrt(predictionError/count);
+        holdError = std::sqrt(holdError/count);
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Prediction" << lead << "s ahead: RMS error" << predictionError << "against" << holdError << "without prediction";
+        if(predictionError>holdError)
+        {
+            yCIWarning(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The predictor is less accurate than the current norms";
+            return false;
+        }
+        return true;
+    }
+
+    void reportRate(const std::chrono::steady_clock::duration elapsed)
+    {
+        double elapsedTime = std::chrono::duration<double>(elapsed).count();
+        double rate = elapsedTime>0 ? recording.size()/elapsedTime : 0.0;
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Replayed" << recording.size() << "ticks in" << elapsedTime << "s:" << rate << "ticks/s";
+    }
+
+    bool writeOutput(const std::string& path)
+    {
+        std::ofstream file(path);
+        if(!file)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to write" << path;
+            return false;
+        }
+        for(const std::string& line : outputLines)
+            file << line << '\n';
+        return static_cast<bool>(file);
+    }
+
+    /**
+     * @brief Compare the output with a golden log
+     *
+     * @param path the path of the golden log
+     * @return true if the output matches the golden log
+     * @return false otherwise
+     */
+    bool compareWithGolden(const std::string& path)
+    {
+        std::ifstream file(path);
+        if(!file)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to read" << path;
+            return false;
+        }
+
+        std::vector<std::string> goldenLines;
+        for(std::string line; std::getline(file, line);)
+            goldenLines.push_back(line);
+
+        size_t differences = 0;
+        size_t numberOfLines = std::max(goldenLines.size(), outputLines.size());
+        for(size_t i=0; i<numberOfLines; i++)
+        {
+            const std::string& golden = i<goldenLines.size() ? goldenLines[i] : std::string();
+            const std::string& output = i<outputLines.size() ? outputLines[i] : std::string();
+            if(golden==output)
+                continue;
+
+            if(differences==0)
+                yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "First difference at line" << i+1 << ": expected" << golden << "got" << output;
+            differences++;
+        }
+
+        if(differences>0)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << differences << "lines differ from the golden log" << path;
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The output matches the golden log" << path;
+        return true;
+    }
+
+    int run(yarp::os::ResourceFinder& rf)
+    {
+        if(!rf.check("recording"))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter: recording";
+            return EXIT_FAILURE;
+        }
+
+        std::string error;
+        std::string recordingPath = rf.find("recording").asString();
+        if(!recording.open(recordingPath, error))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the recording:" << error;
+            return EXIT_FAILURE;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Opened" << recordingPath << "with" << recording.size() << "ticks";
+
+        bool result = recording.getHeader().source==TickRecordingHeader::Source::Retargeting ? replayRetargeting(rf) : replayDisplay(rf);
+        if(!result)
+            return EXIT_FAILURE;
+
+        if(rf.check("output") && !writeOutput(rf.find("output").asString()))
+            return EXIT_FAILURE;
+
+        if(rf.check("golden") && !compareWithGolden(rf.find("golden").asString()))
+            return EXIT_FAILURE;
+
+        return EXIT_SUCCESS;
+    }
+};
+
+int main(int argc, char * argv[])
+{
+    // the replay does not use the YARP network
+    yarp::os::ResourceFinder rf;
+    rf.setDefaultContext("WeightRetargeting");
+    rf.configure(argc, argv);
+
+    WeightRetargetingReplay replay;
+    return replay.run(rf);
+}
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <limits>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/LogStream.h>
+#include <yarp/os/Stamp.h>
+#include <yarp/os/Time.h>
+
+#include "WrenchAcquisition.h"
+#include "WeightRetargetingLogComponent.h"
+
+bool WrenchAcquisition::configure(const yarp::os::Searchable& config, const std::vector<std::string>& inputNames, const std::string& portPrefix)
+{
+    // read staleness_window
+    if(!config.check("staleness_window"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter staleness_window, using default value:"<<stalenessWindow;
+    } else
+    {
+        stalenessWindow = config.find("staleness_window").asFloat64();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter staleness_window:" << stalenessWindow;
+    }
+
+    // read orientation_port_names
+    if(!config.check("orientation_port_names"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter orientation_port_names, the z-axis of the wrenches is assumed opposite to the gravity";
+    } else
+    {
+        yarp::os::Bottle* orientationPortNamesBottle = config.find("orientation_port_names").asList();
+        if(orientationPortNamesBottle==nullptr || orientationPortNamesBottle->size()!=inputNames.size())
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter orientation_port_names must have a port name for each input";
+            return false;
+        }
+        for(size_t i=0; i<orientationPortNamesBottle->size(); i++)
+        {
+            std::string portName = orientationPortNamesBottle->get(i).asString();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found orientation port name:"<<portName;
+            orientationPortNames.push_back(portPrefix+"/"+portName+":i");
+        }
+    }
+
+    // read time_alignment
+    if(!config.check("time_alignment"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter time_alignment, using default value:"<<timeAlignment;
+    } else
+    {
+        timeAlignment = config.find("time_alignment").asBool();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter time_alignment:" << timeAlignment;
+    }
+
+    // read alignment_buffer_size
+    if(!config.check("alignment_buffer_size"))
+    {
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter alignment_buffer_size, using default value:"<<alignmentBufferSize;
+    } else
+    {
+        alignmentBufferSize = config.find("alignment_buffer_size").asInt32();
+        if(alignmentBufferSize<2)
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Parameter alignment_buffer_size must be at least 2";
+            return false;
+        }
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter alignment_buffer_size:" << alignmentBufferSize;
+    }
+
+    // open input ports
+    inputPorts.reserve(inputNames.size());
+    for(const std::string& inputName : inputNames)
+    {
+        std::string portName = portPrefix+"/"+inputName+":i";
+        inputPorts.push_back(std::make_unique<yarp::os::BufferedPort<yarp::sig::Vector>>());
+        if(timeAlignment)
+            inputPorts.back()->setStrict();
+        if(!inputPorts.back()->open(portName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open input port:"<< portName;
+            return false;
+        }
+    }
+
+    // open orientation ports
+    for(const std::string& portName : orientationPortNames)
+    {
+        orientationPorts.push_back(std::make_unique<yarp::os::BufferedPort<yarp::sig::Vector>>());
+        if(!orientationPorts.back()->open(portName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open orientation port:"<< portName;
+            return false;
+        }
+    }
+    inputRotations.resize(orientationPorts.size());
+    rotationArrivalTimes.assign(orientationPorts.size(), -std::numeric_limits<double>::infinity());
+
+    // only the latest wrench is needed without the time alignment
+    inputSeries.resize(inputPorts.size());
+    for(WrenchTimeSeries& series : inputSeries)
+        series.configure(timeAlignment ? alignmentBufferSize : 1);
+    alignedWrenches.resize(inputPorts.size());
+
+    return true;
+}
+
+void WrenchAcquisition::useCallbacks(Listener& listener)
+{
+    this->listener = &listener;
+    inputCallbacks.reserve(inputPorts.size());
+    for(size_t i=0; i<inputPorts.size(); i++)
+    {
+        inputCallbacks.push_back(std::make_unique<WrenchCallback>(*this, i));
+        inputPorts[i]->useCallback(*inputCallbacks[i]);
+    }
+}
+
+void WrenchAcquisition::close()
+{
+    // close input ports, stopping their callbacks
+    for(auto & port : inputPorts)
+    {
+        if(listener!=nullptr)
+            port->disableCallback();
+        port->close();
+    }
+
+    // close orientation ports
+    for(auto & port : orientationPorts)
+        port->close();
+}
+
+void WrenchAcquisition::read(const double time)
+{
+    for(size_t i=0; i<inputPorts.size(); i++)
+    {
+        yarp::sig::Vector* wrench = inputPorts[i]->read(false);
+        while(wrench!=nullptr)
+        {
+            storeWrench(i, *wrench, time);
+            wrench = timeAlignment ? inputPorts[i]->read(false) : nullptr;
+        }
+    }
+}
+
+double WrenchAcquisition::getWrenches(const double time, std::vector<const double*>& wrenches)
+{
+    // take the latest wrenches, nullptr if a wrench is not available
+    wrenches.resize(inputSeries.size());
+    double commonTime = std::numeric_limits<double>::infinity();
+    for(size_t i=0; i<inputSeries.size(); i++)
+    {
+        const WrenchTimeSeries& series = inputSeries[i];
+        bool available = !series.empty() && time-series.getLastArrivalTime()<=stalenessWindow;
+        wrenches[i] = available ? series.getNewest().data() : nullptr;
+        if(available)
+            commonTime = std::min(commonTime, series.getNewestTime());
+    }
+
+    // interpolate the available wrenches at the newest timestamp covered by all of them
+    if(timeAlignment)
+    {
+        for(size_t i=0; i<inputSeries.size(); i++)
+        {
+            if(wrenches[i]==nullptr)
+                continue;
+            inputSeries[i].interpolate(commonTime, alignedWrenches[i]);
+            wrenches[i] = alignedWrenches[i].data();
+        }
+    }
+
+    return commonTime<std::numeric_limits<double>::infinity() ? commonTime : time;
+}
+
+void WrenchAcquisition::getWrenchTimes(std::vector<double>& times) const
+{
+    times.resize(inputSeries.size());
+    for(size_t i=0; i<inputSeries.size(); i++)
+        times[i] = inputSeries[i].empty() ? std::numeric_limits<double>::quiet_NaN() : inputSeries[i].getNewestTime();
+}
+
+void WrenchAcquisition::getRotations(const double time, std::vector<const double*>& rotations)
+{
+    rotations.resize(inputPorts.size());
+    for(size_t i=0; i<orientationPorts.size(); i++)
+    {
+        yarp::sig::Vector* orientation = orientationPorts[i]->read(false);
+        if(orientation!=nullptr)
+        {
+            if(WeightDisplayCore::orientationToRotation(orientation->data(), orientation->size(), inputRotations[i].data()))
+                rotationArrivalTimes[i] = time;
+            else
+                yCIWarningThrottle(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX, 5.0) << "Invalid orientation on" << orientationPortNames[i] << "(9 or 4 values expected)";
+        }
+        rotations[i] = time-rotationArrivalTimes[i]<=stalenessWindow ? inputRotations[i].data() : nullptr;
+    }
+}
+
+void WrenchAcquisition::storeWrench(const size_t input, const yarp::sig::Vector& wrench, const double time)
+{
+    double stampTime = time;
+    yarp::os::Stamp stamp;
+    if(timeAlignment && inputPorts[input]->getEnvelope(stamp) && stamp.isValid())
+        stampTime = stamp.getTime();
+
+    inputSeries[input].push(stampTime, wrench.data(), wrench.size(), time);
+}
+
+void WrenchAcquisition::onRead(const size_t input, const yarp::sig::Vector& wrench)
+{
+    double time = yarp::os::Time::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    storeWrench(input, wrench, time);
+    listener->onWrench(time);
+}
+
+bool WeightAcquisition::configure(const yarp::os::Searchable& config, const std::string& portPrefix)
+{
+    // read weight_port_name, the weight is then read from a WeightDisplayModule instead of the wrenches
+    readPublishedWeight = config.check("weight_port_name");
+    if(readPublishedWeight)
+    {
+        std::string weightPortName = portPrefix+"/"+config.find("weight_port_name").asString();
+        yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter weight_port_name, reading the weight from" << weightPortName;
+
+        // read staleness_window
+        if(!config.check("staleness_window"))
+        {
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Missing parameter staleness_window, using default value:"<<stalenessWindow;
+        } else
+        {
+            stalenessWindow = config.find("staleness_window").asFloat64();
+            yCIInfo(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Found parameter staleness_window:" << stalenessWindow;
+        }
+
+        if(!weightPort.open(weightPortName))
+        {
+            yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "Unable to open the port" << weightPortName;
+            return false;
+        }
+        weightArrivalTime = -stalenessWindow;
+        return true;
+    }
+
+    // read the input names
+    if(!core.configure(config))
+        return false;
+
+    if(core.useVelocity)
+    {
+        yCIError(WEIGHT_RETARGETING_LOG_COMPONENT, LOG_PREFIX) << "The velocity check of the inputs is not supported, the velocities are checked by the actuator groups";
+        return false;
+    }
+
+    if(!wrenchAcquisition.configure(config, core.inputNames, portPrefix))
+        return false;
+
+    wrenches.assign(core.inputNames.size(), nullptr);
+    rotations.assign(core.inputNames.size(), nullptr);
+    rotatedWrenches.resize(core.inputNames.size());
+    return true;
+}
+
+void WeightAcquisition::close()
+{
+    if(readPublishedWeight)
+        weightPort.close();
+    else
+        wrenchAcquisition.close();
+}
+
+void WeightAcquisition::update()
+{
+    double time = yarp::os::Time::now();
+    if(readPublishedWeight)
+    {
+        readWeight(time);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(wrenchAcquisition.mutex);
+    wrenchAcquisition.read(time);
+    measurementTime = wrenchAcquisition.getWrenches(time, wrenches);
+
+    // express the wrenches in the gravity frame, the wrenches without a recent orientation are not available.
+    // The offset of the weight is removed by the calibration of the actuator groups
+    if(wrenchAcquisition.useOrientation())
+    {
+        wrenchAcquisition.getRotations(time, rotations);
+        WeightDisplayCore::rotateWrenches(rotations, wrenches, rotatedWrenches);
+    }
+
+    weight = core.computeWeight(wrenches, velocities);
+}
+
+void WeightAcquisition::readWeight(const double time)
+{
+    // the port keeps only the latest weight
+    const yarp::sig::Vector* message = weightPort.read(false);
+    if(message!=nullptr && message->size()>0)
+    {
+        weight = (*message)[0];
+        weightArrivalTime = time;
+
+        // use the timestamp of the wrenches of the weight, if valid
+        measurementTime = time;
+        yarp::os::Stamp stamp;
+        if(weightPort.getEnvelope(stamp) && stamp.isValid())
+            measurementTime = stamp.getTime();
+    }
+
+    // as for the wrenches, a stale weight is not available
+    if(time-weightArrivalTime>stalenessWindow)
+    {
+        weight = 0.0;
+        measurementTime = time;
+    }
+}
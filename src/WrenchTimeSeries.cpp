@@ -0,0 +1,73 @@
+#include <algorithm>
+
+#include "WrenchTimeSeries.h"
+
+void WrenchTimeSeries::configure(const size_t capacity)
+{
+    times.assign(std::max<size_t>(capacity, 1), 0.0);
+    wrenches.assign(times.size(), Wrench{});
+    first = 0;
+    count = 0;
+    lastArrivalTime = 0.0;
+}
+
+void WrenchTimeSeries::push(const double time, const double* wrench, const size_t size, const double arrivalTime)
+{
+    size_t slot;
+    if(count>0 && time<getNewestTime())
+    {
+        // the history must be ordered by timestamp, and a discarded wrench does not keep the input alive
+        return;
+    }
+    else if(count>0 && time==getNewestTime())
+    {
+        slot = getSlot(count-1);
+    }
+    else if(count<times.size())
+    {
+        slot = getSlot(count);
+        count++;
+    }
+    else
+    {
+        // overwrite the oldest wrench
+        slot = first;
+        first = (first+1)%times.size();
+    }
+
+    lastArrivalTime = arrivalTime;
+    times[slot] = time;
+    Wrench& storedWrench = wrenches[slot];
+    for(size_t i=0; i<WRENCH_SIZE; i++)
+        storedWrench[i] = i<size ? wrench[i] : 0.0;
+}
+
+bool WrenchTimeSeries::interpolate(const double time, Wrench& wrench) const
+{
+    if(count==0)
+        return false;
+
+    // hold the ends of the history
+    if(time<=getOldestTime())
+    {
+        wrench = wrenches[getSlot(0)];
+        return true;
+    }
+    if(time>=getNewestTime())
+    {
+        wrench = getNewest();
+        return true;
+    }
+
+    // the history is short, so the enclosing wrenches are searched linearly from the newest
+    size_t after = count-1;
+    while(after>0 && times[getSlot(after-1)]>time)
+        after--;
+
+    const size_t beforeSlot = getSlot(after-1);
+    const size_t afterSlot = getSlot(after);
+    const double ratio = (time-times[beforeSlot])/(times[afterSlot]-times[beforeSlot]);
+    for(size_t i=0; i<WRENCH_SIZE; i++)
+        wrench[i] = wrenches[beforeSlot][i] + ratio*(wrenches[afterSlot][i]-wrenches[beforeSlot][i]);
+    return true;
+}
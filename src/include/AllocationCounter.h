@@ -0,0 +1,31 @@
+#ifndef WEIGHT_RETARGETING_ALLOCATION_COUNTER_H
+#define WEIGHT_RETARGETING_ALLOCATION_COUNTER_H
+
+#include <cstddef>
+
+/**
+ * @brief Hook counting the heap allocations made by the calling thread.
+ * The global allocation operators are replaced only if the project is built with
+ * the WEIGHT_RETARGETING_COUNT_ALLOCATIONS option, otherwise the count is always zero.
+ */
+class AllocationCounter
+{
+public:
+
+    /**
+     * @brief Check if the allocations are being counted
+     * 
+     * @return true if the project has been built with WEIGHT_RETARGETING_COUNT_ALLOCATIONS
+     * @return false otherwise
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Get the number of heap allocations made by the calling thread so far
+     * 
+     * @return std::size_t the number of allocations
+     */
+    static std::size_t getThreadCount();
+};
+
+#endif // WEIGHT_RETARGETING_ALLOCATION_COUNTER_H
@@ -0,0 +1,70 @@
+#ifndef WEIGHT_RETARGETING_BATCHED_ACTUATION_COMMAND_H
+#define WEIGHT_RETARGETING_BATCHED_ACTUATION_COMMAND_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <yarp/os/Portable.h>
+
+/**
+ * @brief Actuation commands of a control cycle sent in a single message, in the form ((<actuator_name> <intensity>)+).
+ * The message is written in the binary format of a yarp::os::Bottle, so that the receivers read it as a Bottle.
+ * Unlike a Bottle, it refers to the names of the actuators shared with its writer instead of copying them,
+ * so filling and writing a message do not allocate once it has been used with all of the actuators.
+ */
+class BatchedActuationCommand : public yarp::os::Portable
+{
+public:
+
+    // Names of the actuators, shared by the messages which may be still being written by the port
+    using ActuatorNames = std::shared_ptr<const std::vector<std::string>>;
+
+    /**
+     * @brief Remove the commands of the message, keeping its storage
+     *
+     * @param actuatorNames the names of the actuators of the next commands
+     */
+    void clear(const ActuatorNames& actuatorNames);
+
+    /**
+     * @brief Add the command of an actuator
+     *
+     * @param actuator the index of the actuator in the names
+     * @param intensity the intensity of the command
+     */
+    void add(const size_t actuator, const double intensity)
+    {
+        commands.push_back({actuator, intensity});
+    }
+
+    size_t size() const { return commands.size(); }
+
+    const std::string& getActuator(const size_t command) const { return (*actuatorNames)[commands[command].actuator]; }
+
+    double getIntensity(const size_t command) const { return commands[command].intensity; }
+
+    /**
+     * @brief Read a message, the names of the actuators are taken from it
+     *
+     * @param reader the connection
+     * @return true if the message is a list of (<actuator_name> <intensity>) pairs
+     * @return false otherwise
+     */
+    bool read(yarp::os::ConnectionReader& reader) override;
+
+    bool write(yarp::os::ConnectionWriter& writer) const override;
+
+private:
+
+    struct Command
+    {
+        size_t actuator;
+        double intensity;
+    };
+
+    ActuatorNames actuatorNames;
+    std::vector<Command> commands;
+};
+
+#endif // WEIGHT_RETARGETING_BATCHED_ACTUATION_COMMAND_H
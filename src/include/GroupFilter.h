@@ -0,0 +1,71 @@
+#ifndef WEIGHT_RETARGETING_GROUP_FILTER_H
+#define WEIGHT_RETARGETING_GROUP_FILTER_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Filter applied to the norm of an actuator group before it is mapped to the actuation intensity.
+ * The state has a fixed size, so that the filter never allocates and its cost per sample is constant.
+ */
+class GroupFilter
+{
+public:
+
+    enum class Type
+    {
+        None,
+        LowPass,
+        MovingAverage,
+        Median,
+        Invalid
+    };
+
+    // Maximum number of samples of the moving average and median windows
+    static constexpr size_t MAX_WINDOW = 16;
+
+    static Type typeFromString(const std::string& type);
+
+    static std::string typeToString(const Type type);
+
+    /**
+     * @brief Configure the filter and reset its state
+     *
+     * @param type the type of the filter
+     * @param parameter the smoothing factor in (0,1] of the low-pass filter, or the number of samples in [1,MAX_WINDOW] of the window filters
+     * @return true if the parameter is valid for the type
+     * @return false otherwise
+     */
+    bool configure(const Type type, const double parameter);
+
+    /**
+     * @brief Reset the state of the filter, the next sample initializes it
+     */
+    void reset();
+
+    /**
+     * @brief Filter a new sample
+     *
+     * @param value the new sample
+     * @return double the filtered value
+     */
+    double apply(const double value);
+
+    Type getType() const { return type; }
+
+private:
+
+    Type type{Type::None};
+    double alpha{1.0}; // smoothing factor of the low-pass filter
+    size_t window{1}; // number of samples of the window filters
+
+    // State
+    double output{0.0}; // last output of the low-pass filter
+    std::array<double, MAX_WINDOW> samples{}; // ring buffer of the window filters
+    size_t next{0}; // next slot of the ring buffer
+    size_t count{0}; // number of valid samples in the ring buffer
+    double sum{0.0}; // running sum of the moving average
+};
+
+#endif // WEIGHT_RETARGETING_GROUP_FILTER_H
@@ -0,0 +1,93 @@
+#ifndef WEIGHT_RETARGETING_GROUP_PREDICTOR_H
+#define WEIGHT_RETARGETING_GROUP_PREDICTOR_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Predictor extrapolating the norm of an actuator group ahead in time, so that the actuation
+ * compensates the latency of the acquisition, of the transport and of the suit.
+ * The state has a fixed size, so that the predictor never allocates and its cost per sample is constant.
+ */
+class GroupPredictor
+{
+public:
+
+    enum class Type
+    {
+        None,
+        Linear, // least-squares line over the latest samples
+        Kalman, // constant-velocity Kalman filter
+        Invalid
+    };
+
+    // Maximum number of samples of the linear predictor
+    static constexpr size_t MAX_WINDOW = 16;
+
+    static Type typeFromString(const std::string& type);
+
+    static std::string typeToString(const Type type);
+
+    /**
+     * @brief Configure the linear predictor and reset its state
+     *
+     * @param window the number of samples in [2,MAX_WINDOW] of the fitted line
+     * @return true if the window is valid
+     * @return false otherwise
+     */
+    bool configureLinear(const size_t window);
+
+    /**
+     * @brief Configure the Kalman predictor and reset its state
+     *
+     * @param processNoise the spectral density of the rate of change of the slope of the norm, in norm^2/s^3
+     * @param measurementNoise the variance of the measured norm, in norm^2
+     * @return true if the noises are positive
+     * @return false otherwise
+     */
+    bool configureKalman(const double processNoise, const double measurementNoise);
+
+    /**
+     * @brief Reset the state of the predictor, the next sample initializes it
+     */
+    void reset();
+
+    /**
+     * @brief Add a new sample and extrapolate the norm
+     *
+     * @param value the new norm
+     * @param time the timestamp of the norm in seconds, the samples not newer than the previous one only update the extrapolation
+     * @param lead the time ahead of the timestamp of the norm to be predicted, in seconds
+     * @return double the predicted norm, not negative
+     */
+    double apply(const double value, const double time, const double lead);
+
+    Type getType() const { return type; }
+
+private:
+
+    Type type{Type::None};
+
+    // Linear predictor
+    size_t window{2};
+    std::array<double, MAX_WINDOW> samples{}; // ring buffer of the norms
+    std::array<double, MAX_WINDOW> times{}; // ring buffer of the timestamps
+    size_t next{0};
+    size_t count{0};
+
+    // Kalman predictor: state (norm, slope) and its covariance
+    double processNoise{1.0};
+    double measurementNoise{1.0};
+    double norm{0.0};
+    double slope{0.0};
+    double p00{0.0}, p01{0.0}, p11{0.0};
+    double lastTime{0.0};
+
+    // Slope of the least-squares line of the samples in the ring buffer
+    double computeSlope() const;
+
+    void updateKalman(const double value, const double time);
+};
+
+#endif // WEIGHT_RETARGETING_GROUP_PREDICTOR_H
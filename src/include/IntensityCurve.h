@@ -0,0 +1,91 @@
+#ifndef WEIGHT_RETARGETING_INTENSITY_CURVE_H
+#define WEIGHT_RETARGETING_INTENSITY_CURVE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "RetargetingKernel.h"
+
+/**
+ * @brief Curve mapping the normalized norm of an actuator group to the actuation intensity.
+ * The curve is compiled when it is configured into a dense lookup table over [0,1], so that mapping a value
+ * costs one multiplication and one load. The table has a fixed size, so that copying a curve never allocates.
+ */
+class IntensityCurve
+{
+public:
+
+    enum class Type
+    {
+        Linear,
+        Power, // Stevens' power law
+        Logarithmic,
+        PiecewiseLinear,
+        Stepped,
+        Invalid
+    };
+
+    // Number of intervals of the lookup table over the normalized values
+    static constexpr size_t RESOLUTION = 4096;
+
+    static Type typeFromString(const std::string& type);
+
+    static std::string typeToString(const Type type);
+
+    IntensityCurve();
+
+    /**
+     * @brief Configure the curve and compile its lookup table
+     *
+     * @param type the type of the curve
+     * @param parameters none for the linear curve, the exponent of the power curve, the gain of the logarithmic curve,
+     * the number of steps of the stepped curve, or the x y pairs of the normalized points of the piecewise linear curve
+     * @return true if the parameters are valid for the type
+     * @return false otherwise
+     */
+    bool configure(const Type type, const std::vector<double>& parameters);
+
+    /**
+     * @brief Maps a measured value to the actuation command value, as RetargetingKernel::computeActuationIntensity for the linear curve
+     *
+     * @param measuredValue the measured value
+     * @param minThreshold the value mapped to the null intensity
+     * @param maxThreshold the value mapped to the maximum intensity
+     * @return double the value of the actuation command
+     */
+    double map(const double measuredValue, const double minThreshold, const double maxThreshold) const
+    {
+        double normalizedValue = (measuredValue - minThreshold) / (maxThreshold - minThreshold);
+        if(!(normalizedValue>0))
+            return 0.0;
+        if(normalizedValue>1.0) normalizedValue = 1.0;
+
+        return table[static_cast<size_t>(normalizedValue*RESOLUTION)];
+    }
+
+    Type getType() const { return type; }
+
+private:
+
+    Type type{Type::Linear};
+
+    // Intensity of the normalized value i/RESOLUTION, truncated as the linear mapping
+    std::array<std::uint8_t, RESOLUTION+1> table{};
+
+    /**
+     * @brief Evaluate the curve
+     *
+     * @param type the type of the curve
+     * @param parameters the validated parameters of the curve
+     * @param normalizedValue the normalized value in [0,1]
+     * @return double the normalized intensity in [0,1]
+     */
+    static double evaluate(const Type type, const std::vector<double>& parameters, const double normalizedValue);
+};
+
+static_assert(WEIGHT_RETARGETING_MAX_INTENSITY<=UINT8_MAX, "The intensities of the lookup table must fit in a byte");
+
+#endif // WEIGHT_RETARGETING_INTENSITY_CURVE_H
@@ -0,0 +1,189 @@
+#ifndef WEIGHT_RETARGETING_JOINT_ACQUISITION_THREAD_H
+#define WEIGHT_RETARGETING_JOINT_ACQUISITION_THREAD_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <yarp/os/PeriodicThread.h>
+
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/ITorqueControl.h>
+#include <yarp/dev/ICurrentControl.h>
+#include <yarp/dev/IEncodersTimed.h>
+#include <yarp/dev/IPreciselyTimed.h>
+
+#include "TripleBuffer.h"
+
+class ParallelBoardReader;
+class WeightAcquisition;
+
+/**
+ * @brief Acquisition of the retargeted values and of the velocities of the joints of a retargeting,
+ * followed by the weight held by the end effectors if it is retargeted (with a null velocity).
+ * The latest sample is published through a lock-free buffer, so that the consumer never waits for the control board.
+ */
+class JointAcquisition
+{
+public:
+
+    enum class RetargetedValue
+    {
+        JointTorque,
+        MotorCurrent,
+        Weight, // only the weight held by the end effectors, no joint is read
+        Invalid
+    };
+
+    static RetargetedValue retargetedValuefromString(const std::string& name)
+    {
+        if(name=="joint_torque")
+            return RetargetedValue::JointTorque;
+        if(name=="motor_current")
+            return RetargetedValue::MotorCurrent;
+        if(name=="weight")
+            return RetargetedValue::Weight;
+        
+        return RetargetedValue::Invalid;
+    }
+
+    struct JointSample
+    {
+        std::vector<double> interfaceValues;
+        std::vector<double> velocities;
+        double time{0.0}; // acquisition time in seconds
+        double measurementTime{0.0}; // timestamp of the data given by the control board, or the time before the reading if not available
+        double acquisitionDuration{0.0}; // duration of the reading of the retargeted values in seconds
+        double velocityReadDuration{0.0}; // duration of the reading of the velocities in seconds
+    };
+
+    const std::string LOG_PREFIX = "JointAcquisition";
+
+    /**
+     * @brief Get the interfaces of the control board and allocate the samples
+     * 
+     * @param controlBoard the control board of the retargeted joints
+     * @param retargetedValue the value to be read
+     * @param useVelocities whether to read the velocities of the joints
+     * @param numberOfJoints the number of joints of the control board
+     * @param weightAcquisition the weight added after the joints, nullptr if it is not retargeted
+     * @return true if the interfaces are available
+     * @return false otherwise
+     */
+    bool configure(yarp::dev::PolyDriver& controlBoard, const RetargetedValue retargetedValue, const bool useVelocities, const size_t numberOfJoints,
+                   const WeightAcquisition* weightAcquisition);
+
+    /**
+     * @brief Read the joints from several control boards concurrently and allocate the samples
+     * 
+     * @param boardReader the reader of the control boards, already opened, which must outlive the acquisition
+     * @param useVelocities whether to read the velocities of the joints, as configured in the reader
+     * @param numberOfJoints the number of joints read by the reader
+     * @param weightAcquisition the weight added after the joints, nullptr if it is not retargeted
+     * @return true
+     */
+    bool configure(ParallelBoardReader& boardReader, const bool useVelocities, const size_t numberOfJoints, const WeightAcquisition* weightAcquisition);
+
+    /**
+     * @brief Acquire only the weight, without reading any joint, and allocate the samples
+     * 
+     * @param weightAcquisition the weight, updated by the acquisition thread, which must outlive the acquisition
+     * @return true
+     */
+    bool configure(const WeightAcquisition& weightAcquisition);
+
+    /**
+     * @brief Take the latest sample published by the thread, it never blocks
+     * 
+     * @return true if a new sample has been acquired since the last call
+     * @return false otherwise
+     */
+    bool updateSample();
+
+    /**
+     * @brief Get the latest sample taken with updateSample
+     * 
+     * @return const JointSample& the sample
+     */
+    const JointSample& getSample() const;
+
+    /**
+     * @brief Read a new sample and publish it, called by the acquisition thread
+     */
+    void acquire();
+
+private:
+
+    friend class JointAcquisitionThread;
+
+    // Held by the acquisition thread while acquiring, so that removing the acquisition waits only for its own reading
+    std::mutex acquireMutex;
+
+    RetargetedValue retargetedValue{RetargetedValue::Invalid};
+    bool useVelocities{false};
+    yarp::dev::ITorqueControl* iTorqueControl{ nullptr };
+    yarp::dev::ICurrentControl* iCurrentControl{ nullptr };
+    yarp::dev::IEncodersTimed* iEncodersTimed{ nullptr };
+    yarp::dev::IPreciselyTimed* iPreciselyTimed{ nullptr }; // optional
+    ParallelBoardReader* boardReader{ nullptr }; // used instead of the interfaces if set
+    const WeightAcquisition* weightAcquisition{ nullptr }; // weight added after the joints if set
+    size_t numberOfJoints{0};
+
+    std::vector<double> lastVelocities; // the velocities are kept if their acquisition fails
+    TripleBuffer<JointSample> samples;
+
+    // Allocate the samples of the joints and of the weight
+    void allocateSamples(const size_t numberOfJoints, const WeightAcquisition* weightAcquisition);
+
+    // Read the sample from the reader of the control boards, returning false if the values are not available
+    bool readFromBoards(JointSample& sample);
+
+    // Read the sample from the weight only
+    void readWeight(JointSample& sample);
+};
+
+/**
+ * @brief Thread acquiring the joints of one or more retargetings at its own rate, so that the retargeting instances
+ * hosted by a module share a single acquisition thread.
+ */
+class JointAcquisitionThread : public yarp::os::PeriodicThread
+{
+public:
+
+    explicit JointAcquisitionThread(const double period);
+
+    /**
+     * @brief Start acquiring the joints of a retargeting
+     * 
+     * @param acquisition the configured acquisition, which must stay valid until it is removed
+     */
+    void add(JointAcquisition& acquisition);
+
+    /**
+     * @brief Stop acquiring the joints of a retargeting, waiting for the end of its current acquisition
+     * 
+     * @param acquisition the acquisition
+     */
+    void remove(JointAcquisition& acquisition);
+
+    /**
+     * @brief Update the weight in each cycle before the acquisitions, so that the wrenches are read once for all of them.
+     * It must be set before starting the thread.
+     * 
+     * @param weightAcquisition the weight retargeted by the acquisitions, which must outlive the thread
+     */
+    void setWeightAcquisition(WeightAcquisition& weightAcquisition) { this->weightAcquisition = &weightAcquisition; }
+
+protected:
+
+    void run() override;
+
+private:
+
+    // Held only to change the list and to take its next acquisition, each acquisition is read under its own lock
+    std::mutex acquisitionsMutex;
+    std::vector<JointAcquisition*> acquisitions;
+    WeightAcquisition* weightAcquisition{nullptr};
+};
+
+#endif // WEIGHT_RETARGETING_JOINT_ACQUISITION_THREAD_H
@@ -0,0 +1,102 @@
+#ifndef WEIGHT_RETARGETING_LATENCY_STATS_H
+#define WEIGHT_RETARGETING_LATENCY_STATS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Lock-free histogram of latencies with a bounded relative error, in the style of HdrHistogram.
+ * Each power of two is split in SUB_BUCKETS linear buckets, so that the error of a percentile is below 1/SUB_BUCKETS.
+ * It is written by a single thread and it can be read by any thread without blocking the writer.
+ */
+class LatencyHistogram
+{
+public:
+
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+    // Latencies above 2^40 ns (about 18 minutes) are recorded as the maximum trackable value
+    static constexpr int MAX_VALUE_BITS = 40;
+    static constexpr uint64_t MAX_VALUE = (uint64_t(1) << MAX_VALUE_BITS) - 1;
+    static constexpr size_t NUMBER_OF_BUCKETS = (MAX_VALUE_BITS-SUB_BUCKET_BITS+1)*SUB_BUCKETS;
+
+    /**
+     * @brief Record a latency
+     *
+     * @param nanoseconds the latency in nanoseconds
+     */
+    void record(uint64_t nanoseconds);
+
+    /**
+     * @brief Record a latency
+     *
+     * @param seconds the latency in seconds, negative values are recorded as zero
+     */
+    void recordSeconds(const double seconds);
+
+    /**
+     * @brief Get a percentile of the recorded latencies
+     *
+     * @param percentile the percentile in [0,100]
+     * @return double the highest latency of the bucket containing the percentile in seconds, 0 if nothing has been recorded
+     */
+    double getPercentile(const double percentile) const;
+
+    uint64_t getCount() const { return count.load(std::memory_order_relaxed); }
+
+    double getMax() const { return max.load(std::memory_order_relaxed)*1e-9; }
+
+    /**
+     * @brief Clear the recorded latencies, the samples recorded concurrently may be lost
+     */
+    void reset();
+
+private:
+
+    std::array<std::atomic<uint64_t>, NUMBER_OF_BUCKETS> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> max{0};
+
+    static size_t getBucketIndex(const uint64_t value);
+
+    static uint64_t getBucketHighestValue(const size_t index);
+};
+
+/**
+ * @brief Latency histograms of the stages between the measurement of a joint sample and the sending of the haptic commands
+ */
+class LatencyStats
+{
+public:
+
+    enum class Stage
+    {
+        Acquire, // reading of the retargeted values
+        VelocityRead, // reading of the joint velocities
+        Compute, // generation of the actuation commands
+        Serialize, // preparation of the output messages
+        Write, // writing of the output messages
+        EndToEnd, // from the timestamp of the joint sample to the end of the writing
+        PredictionLead, // time by which the predicted norms anticipate the joint sample, saved from the perceived latency
+        Count
+    };
+
+    static constexpr size_t NUMBER_OF_STAGES = static_cast<size_t>(Stage::Count);
+
+    static std::string stageToString(const Stage stage);
+
+    LatencyHistogram& get(const Stage stage) { return histograms[static_cast<size_t>(stage)]; }
+
+    const LatencyHistogram& get(const Stage stage) const { return histograms[static_cast<size_t>(stage)]; }
+
+    void reset();
+
+private:
+
+    std::array<LatencyHistogram, NUMBER_OF_STAGES> histograms;
+};
+
+#endif // WEIGHT_RETARGETING_LATENCY_STATS_H
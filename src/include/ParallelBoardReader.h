@@ -0,0 +1,131 @@
+#ifndef WEIGHT_RETARGETING_PARALLEL_BOARD_READER_H
+#define WEIGHT_RETARGETING_PARALLEL_BOARD_READER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <yarp/dev/PolyDriver.h>
+#include <yarp/dev/ITorqueControl.h>
+#include <yarp/dev/ICurrentControl.h>
+#include <yarp/dev/IEncodersTimed.h>
+#include <yarp/dev/IPreciselyTimed.h>
+
+#include "JointAcquisitionThread.h"
+#include "LatencyStats.h"
+#include "TaskPool.h"
+
+/**
+ * @brief Reads the retargeted values of several control boards concurrently, instead of the serial reading of a remapper.
+ * Each board is opened with its own remote_controlboard and its axes are scattered in the joint order of the retargeting.
+ * The boards are read by a pool of threads, which can be shared with other readers, and the read time of each board is recorded.
+ */
+class ParallelBoardReader : private TaskPool::Job
+{
+public:
+
+    using RetargetedValue = JointAcquisition::RetargetedValue;
+
+    /**
+     * @brief Result of a reading of all of the boards
+     */
+    struct Reading
+    {
+        double* values{nullptr}; // retargeted values of the joints, in the joint order of the retargeting
+        double* velocities{nullptr}; // velocities of the joints, nullptr if they are not read
+        bool valuesRead{false}; // true if the values of all of the boards have been read
+        bool velocitiesRead{false}; // true if the velocities of all of the boards have been read
+        double measurementTime{0.0}; // oldest timestamp of the boards, or the time before the reading if not available
+        double velocityReadDuration{0.0}; // longest reading of the velocities of a board in seconds
+    };
+
+    const std::string LOG_PREFIX = "ParallelBoardReader";
+
+    ParallelBoardReader() = default;
+
+    ~ParallelBoardReader() override;
+
+    ParallelBoardReader(const ParallelBoardReader&) = delete;
+
+    ParallelBoardReader& operator=(const ParallelBoardReader&) = delete;
+
+    /**
+     * @brief Open the control boards and map their axes to the joints.
+     * The boards without any of the joints are closed.
+     *
+     * @param remoteBoards the names of the remote control boards, with the robot prefix
+     * @param localPortPrefix the prefix of the local ports of the control boards
+     * @param jointNames the names of the joints in the order of the retargeting
+     * @param retargetedValue the value to be read
+     * @param useVelocities whether to read the velocities of the joints
+     * @param pool the pool of threads reading the boards, which must outlive the reader
+     * @return true if all of the joints have been found on the boards
+     * @return false otherwise
+     */
+    bool open(const std::vector<std::string>& remoteBoards, const std::string& localPortPrefix, const std::vector<std::string>& jointNames,
+              const RetargetedValue retargetedValue, const bool useVelocities, TaskPool& pool);
+
+    /**
+     * @brief Close the control boards
+     */
+    void close();
+
+    /**
+     * @brief Read all of the boards concurrently, returning once all of them have been read.
+     * It must be called by the single thread running the jobs of the pool.
+     *
+     * @param reading the output buffers and the result of the reading
+     */
+    void read(Reading& reading);
+
+    size_t getNumberOfBoards() const { return boards.size(); }
+
+    const std::string& getBoardName(const size_t board) const { return boards[board]->name; }
+
+    LatencyHistogram& getBoardReadTimes(const size_t board) { return boards[board]->readTimes; }
+
+private:
+
+    struct Board
+    {
+        std::string name;
+        yarp::dev::PolyDriver driver;
+        yarp::dev::ITorqueControl* iTorqueControl{nullptr};
+        yarp::dev::ICurrentControl* iCurrentControl{nullptr};
+        yarp::dev::IEncodersTimed* iEncodersTimed{nullptr};
+        yarp::dev::IPreciselyTimed* iPreciselyTimed{nullptr}; // optional
+        std::vector<int> jointIndexes; // index of the joint of each axis of the board, -1 if it is not retargeted
+        std::vector<double> values;
+        std::vector<double> velocities;
+        bool valuesRead{false};
+        bool velocitiesRead{false};
+        double measurementTime{0.0};
+        double velocityReadDuration{0.0};
+        LatencyHistogram readTimes; // time to read the values and the velocities of the board
+    };
+
+    RetargetedValue retargetedValue{RetargetedValue::Invalid};
+    bool useVelocities{false};
+    std::vector<std::unique_ptr<Board>> boards;
+    TaskPool* pool{nullptr};
+    Reading* currentReading{nullptr}; // reading in progress, each task reads a board
+
+    /**
+     * @brief Open a control board and map its axes to the joints
+     *
+     * @param board the board, with its name set
+     * @param localPortPrefix the prefix of the local ports of the control board
+     * @param jointNames the names of the joints in the order of the retargeting
+     * @param jointFound whether each joint has already been found on a board, updated with the joints of the board
+     * @return true if the board has been opened
+     * @return false otherwise
+     */
+    bool openBoard(Board& board, const std::string& localPortPrefix, const std::vector<std::string>& jointNames, std::vector<bool>& jointFound);
+
+    // Read a board and scatter its values in the reading
+    void readBoard(Board& board, Reading& reading);
+
+    void runTask(const size_t task) override;
+};
+
+#endif // WEIGHT_RETARGETING_PARALLEL_BOARD_READER_H
@@ -0,0 +1,138 @@
+#ifndef WEIGHT_RETARGETING_KERNEL_H
+#define WEIGHT_RETARGETING_KERNEL_H
+
+#include <string>
+#include <vector>
+
+#define WEIGHT_RETARGETING_MAX_INTENSITY 127
+
+/**
+ * @brief Batch kernel computing the actuation intensities of all of the actuator groups in a single pass.
+ * The norms, offsets, normalizations and clamps are vectorized over the groups, using the widest
+ * instruction set available at runtime. All of the implementations give bit-identical results.
+ * Each joint is squared once per tick, and the groups with the same list of joints share the same norm.
+ */
+class RetargetingKernel
+{
+public:
+
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /**
+     * @brief Get the widest instruction set supported by the running CPU
+     * 
+     * @return InstructionSet the instruction set
+     */
+    static InstructionSet detectInstructionSet();
+
+    static std::string instructionSetToString(const InstructionSet instructionSet);
+
+    /**
+     * @brief Maps a measured value to the actuation command value
+     * 
+     * @param measuredValue the measured value
+     * @param minThreshold the value mapped to the null intensity
+     * @param maxThreshold the value mapped to the maximum intensity
+     * @return double the value of the actuation command
+     */
+    static double computeActuationIntensity(const double measuredValue, const double minThreshold, const double maxThreshold)
+    {
+        double actuationIntensity = 0.0;
+        double normalizedValue = (measuredValue - minThreshold) / (maxThreshold - minThreshold);
+        if(normalizedValue>0)
+        {
+            if(normalizedValue>1.0) normalizedValue = 1.0;
+
+            //TODO check if it's better to use steps
+            actuationIntensity = (int)(normalizedValue*WEIGHT_RETARGETING_MAX_INTENSITY);
+        }
+        return actuationIntensity;
+    }
+
+    /**
+     * @brief Build the data layout used by the kernel
+     * 
+     * @param jointOffsets the CSR offsets of the joints of each group (size: number of groups + 1)
+     * @param jointIndexes the indexes of the joints of the groups
+     * @param numberOfJoints the number of joints
+     * @param instructionSet the instruction set to be used (it must be supported by the CPU)
+     */
+    void configure(const std::vector<int>& jointOffsets, const std::vector<int>& jointIndexes, const size_t numberOfJoints, const InstructionSet instructionSet);
+
+    InstructionSet getInstructionSet() const { return instructionSet; }
+
+    /**
+     * @brief Get the number of distinct norms computed in each tick
+     * 
+     * @return size_t the number of distinct lists of joints over all of the groups
+     */
+    size_t getNumberOfNorms() const { return numberOfNorms; }
+
+    /**
+     * @brief Compute the norms of all of the groups
+     * 
+     * @param interfaceValues the values measured on the joints
+     * @param groupNorms the computed norms of the groups
+     */
+    void computeNorms(const double* interfaceValues, double* groupNorms);
+
+    /**
+     * @brief Compute the actuation intensities of all of the groups from their norms
+     * 
+     * @param groupNorms the norms of the groups
+     * @param offsets the offsets of the groups
+     * @param minThresholds the min thresholds of the groups
+     * @param maxThresholds the max thresholds of the groups
+     * @param intensities the computed intensities of the groups
+     */
+    void computeIntensities(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities);
+
+    /**
+     * @brief Compute the actuation intensities of all of the groups
+     * 
+     * @param interfaceValues the values measured on the joints
+     * @param offsets the offsets of the groups
+     * @param minThresholds the min thresholds of the groups
+     * @param maxThresholds the max thresholds of the groups
+     * @param intensities the computed intensities of the groups
+     */
+    void compute(const double* interfaceValues, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities);
+
+private:
+
+    InstructionSet instructionSet{InstructionSet::Scalar};
+    size_t numberOfGroups{0};
+    size_t numberOfJoints{0};
+    size_t numberOfNorms{0};
+    size_t width{1}; // number of norms or groups processed together
+
+    // Dependency graph: each group reads one of the distinct norms, each norm sums the squares of a list of joints
+    std::vector<int> groupNorms;
+    std::vector<int> normOffsets;
+    std::vector<int> normIndexes;
+
+    // Layout for the vectorized implementations: the norms are split in blocks of width norms,
+    // and for each block the joints of its norms are interleaved row by row. The rows of the
+    // shorter norms are padded with the index of a zero square, which does not change their sum.
+    std::vector<int> blockOffsets; // first row of each block (size: number of blocks + 1)
+    std::vector<int> blockIndexes; // width indexes for each row
+
+    // Working buffers
+    std::vector<double> squares; // the squared interface values followed by the padding zero
+    std::vector<double> norms;
+    std::vector<double> groupNormBuffer; // used by compute
+
+    void computeNormsScalar();
+    void computeNormsSSE2();
+    void computeNormsAVX2();
+    void computeIntensitiesScalar(const size_t firstGroup, const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities);
+    void computeIntensitiesSSE2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities);
+    void computeIntensitiesAVX2(const double* groupNorms, const double* offsets, const double* minThresholds, const double* maxThresholds, double* intensities);
+};
+
+#endif // WEIGHT_RETARGETING_KERNEL_H
@@ -0,0 +1,17 @@
+#ifndef WEIGHT_RETARGETING_LAYOUTS_H
+#define WEIGHT_RETARGETING_LAYOUTS_H
+
+#include "WeightRetargetingCore.h"
+
+/**
+ * @brief Set in a configured core the stages specialized for its layout of the actuator groups,
+ * among the layouts generated at build time from the configuration files (see RetargetingPipeline).
+ * The core keeps the generic stages if none of the layouts matches.
+ * 
+ * @param core the configured core
+ * @return true if a layout matches the core
+ * @return false otherwise
+ */
+bool selectSpecializedStages(WeightRetargetingCore& core);
+
+#endif // WEIGHT_RETARGETING_LAYOUTS_H
@@ -0,0 +1,220 @@
+#ifndef WEIGHT_RETARGETING_PIPELINE_H
+#define WEIGHT_RETARGETING_PIPELINE_H
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "WeightRetargetingCore.h"
+
+/**
+ * @brief Actuator group of a layout known at compile time, defined by the indexes of its joints.
+ * Its norm and its velocity check are unrolled over the joints.
+ */
+template <int... Joints>
+struct RetargetingGroup;
+
+template <>
+struct RetargetingGroup<>
+{
+    static double computeNorm(const double*) { return 0.0; }
+
+    static double addSquares(const double*, const double sum) { return sum; }
+
+    static bool checkVelocity(const double*, const double) { return true; }
+};
+
+template <int Joint, int... Joints>
+struct RetargetingGroup<Joint, Joints...>
+{
+    static double computeNorm(const double* interfaceValues)
+    {
+        return std::sqrt(addSquares(interfaceValues, 0.0));
+    }
+
+    // The squares are summed in the order of the joints, as in the generic kernel, so that the norms are bit-identical
+    static double addSquares(const double* interfaceValues, const double sum)
+    {
+        return RetargetingGroup<Joints...>::addSquares(interfaceValues, sum + interfaceValues[Joint]*interfaceValues[Joint]);
+    }
+
+    static bool checkVelocity(const double* velocities, const double maxVelocity)
+    {
+        return !(velocities[Joint]>maxVelocity) && RetargetingGroup<Joints...>::checkVelocity(velocities, maxVelocity);
+    }
+};
+
+/**
+ * @brief Check whether the joints of a group read at runtime are the ones of a group known at compile time
+ */
+template <typename Group>
+struct RetargetingGroupMatcher;
+
+template <int... Joints>
+struct RetargetingGroupMatcher<RetargetingGroup<Joints...>>
+{
+    static bool matches(const int* jointIndexes, const size_t size)
+    {
+        const int joints[] = {Joints..., -1};
+        if(size!=sizeof...(Joints))
+            return false;
+        for(size_t i=0; i<size; i++)
+        {
+            if(jointIndexes[i]!=joints[i])
+                return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Ordered list of the actuator groups of a layout known at compile time
+ */
+template <typename... Groups>
+struct RetargetingGroupList
+{
+    static constexpr size_t SIZE = sizeof...(Groups);
+
+    static void computeNorms(const double* interfaceValues, double* groupNorms)
+    {
+        computeNorms(interfaceValues, groupNorms, std::index_sequence_for<Groups...>{});
+    }
+
+    static void checkVelocities(const double* velocities, const double maxVelocity, std::vector<bool>& allowedGroups)
+    {
+        checkVelocities(velocities, maxVelocity, allowedGroups, std::index_sequence_for<Groups...>{});
+    }
+
+    static bool matches(const std::vector<int>& jointOffsets, const std::vector<int>& jointIndexes)
+    {
+        if(jointOffsets.size()!=SIZE+1)
+            return false;
+        return matches(jointOffsets, jointIndexes, std::index_sequence_for<Groups...>{});
+    }
+
+private:
+
+    // The packs are expanded in the order of the groups, in a single statement without loops
+    template <size_t... Indexes>
+    static void computeNorms(const double* interfaceValues, double* groupNorms, std::index_sequence<Indexes...>)
+    {
+        const int expansion[] = {0, (groupNorms[Indexes] = Groups::computeNorm(interfaceValues), 0)...};
+        (void)expansion;
+    }
+
+    template <size_t... Indexes>
+    static void checkVelocities(const double* velocities, const double maxVelocity, std::vector<bool>& allowedGroups, std::index_sequence<Indexes...>)
+    {
+        const int expansion[] = {0, (allowedGroups[Indexes] = Groups::checkVelocity(velocities, maxVelocity), 0)...};
+        (void)expansion;
+    }
+
+    template <size_t... Indexes>
+    static bool matches(const std::vector<int>& jointOffsets, const std::vector<int>& jointIndexes, std::index_sequence<Indexes...>)
+    {
+        const bool results[] = {true, RetargetingGroupMatcher<Groups>::matches(jointIndexes.data()+jointOffsets[Indexes], jointOffsets[Indexes+1]-jointOffsets[Indexes])...};
+        for(const bool result : results)
+        {
+            if(!result)
+                return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief Stages of the control cycle specialized at compile time for a fixed layout of the actuator groups.
+ * The norms and the velocity checks are unrolled over the groups and their joints, and the velocity check
+ * is removed if it is not used. The results are the same of the generic stages of WeightRetargetingCore.
+ *
+ * A Layout is generated by WeightRetargetingLayoutGenerator from a configuration file and provides:
+ * - getName(), the name of the layout
+ * - NUMBER_OF_JOINTS and getJointName(joint), the joints in the order of the retargeting
+ * - Groups, the RetargetingGroupList of the actuator groups, where the index NUMBER_OF_JOINTS is the weight
+ */
+template <typename Layout, bool UseVelocity>
+class RetargetingPipeline
+{
+public:
+
+    static void computeNorms(const double* interfaceValues, double* groupNorms)
+    {
+        Layout::Groups::computeNorms(interfaceValues, groupNorms);
+    }
+
+    static void checkVelocities(const double* velocities, const double maxVelocity, std::vector<bool>& allowedGroups)
+    {
+        checkVelocities(velocities, maxVelocity, allowedGroups, std::integral_constant<bool, UseVelocity>{});
+    }
+
+    /**
+     * @brief Check whether the groups read by a core at runtime have the layout of the pipeline
+     *
+     * @param core the configured core
+     * @return true if the joints and the groups are the same of the layout
+     * @return false otherwise
+     */
+    static bool matches(const WeightRetargetingCore& core)
+    {
+        if(core.jointNames.size()!=Layout::NUMBER_OF_JOINTS)
+            return false;
+        for(size_t joint=0; joint<core.jointNames.size(); joint++)
+        {
+            if(core.jointNames[joint]!=Layout::getJointName(joint))
+                return false;
+        }
+        return Layout::Groups::matches(core.groups.jointOffsets, core.groups.jointIndexes);
+    }
+
+    static WeightRetargetingCore::SpecializedStages getStages()
+    {
+        WeightRetargetingCore::SpecializedStages stages;
+        stages.layout = Layout::getName();
+        stages.computeNorms = &computeNorms;
+        stages.checkVelocities = &checkVelocities;
+        return stages;
+    }
+
+private:
+
+    static void checkVelocities(const double* velocities, const double maxVelocity, std::vector<bool>& allowedGroups, std::true_type)
+    {
+        Layout::Groups::checkVelocities(velocities, maxVelocity, allowedGroups);
+    }
+
+    static void checkVelocities(const double*, const double, std::vector<bool>& allowedGroups, std::false_type)
+    {
+        allowedGroups.assign(allowedGroups.size(), true);
+    }
+};
+
+/**
+ * @brief Select the first layout matching a configured core, and set its specialized stages in the core
+ */
+template <typename... Layouts>
+struct RetargetingPipelineSelector;
+
+template <>
+struct RetargetingPipelineSelector<>
+{
+    static bool select(WeightRetargetingCore&) { return false; }
+};
+
+template <typename Layout, typename... Layouts>
+struct RetargetingPipelineSelector<Layout, Layouts...>
+{
+    static bool select(WeightRetargetingCore& core)
+    {
+        if(!RetargetingPipeline<Layout, true>::matches(core))
+            return RetargetingPipelineSelector<Layouts...>::select(core);
+
+        // the velocity check is chosen once, as configured
+        core.specializedStages = core.useVelocities ? RetargetingPipeline<Layout, true>::getStages() : RetargetingPipeline<Layout, false>::getStages();
+        return true;
+    }
+};
+
+#endif // WEIGHT_RETARGETING_PIPELINE_H
@@ -0,0 +1,130 @@
+#ifndef WEIGHT_RETARGETING_SNAPSHOT_BUFFER_H
+#define WEIGHT_RETARGETING_SNAPSHOT_BUFFER_H
+
+#include <atomic>
+#include <mutex>
+
+/**
+ * @brief RCU-style buffer sharing a set of parameters between a single real-time reader and any number of writers.
+ * The reader pins a consistent snapshot without locking, while the writers publish a modified copy of the latest
+ * snapshot in a buffer that is not being read. Writers are serialized among themselves, but never wait for the reader.
+ */
+template <typename T>
+class SnapshotBuffer
+{
+public:
+
+    /**
+     * @brief Initialize all of the buffers, it must be called before sharing the buffer among threads
+     * 
+     * @param value the initial value
+     */
+    void initialize(const T& value)
+    {
+        for(T& buffer : buffers)
+            buffer = value;
+        published.store(0);
+        reading.store(NONE);
+    }
+
+    /**
+     * @brief Pin the latest snapshot (reader side), it must be followed by release
+     * 
+     * @return const T& the snapshot, valid until release is called
+     */
+    const T& acquire()
+    {
+        int index = published.load();
+        while(true)
+        {
+            // announce the buffer being read, then make sure that it is still the published one
+            reading.store(index);
+            const int latest = published.load();
+            if(latest==index)
+                break;
+            index = latest;
+        }
+        return buffers[index];
+    }
+
+    /**
+     * @brief Unpin the snapshot taken with acquire (reader side)
+     */
+    void release()
+    {
+        reading.store(NONE);
+    }
+
+    /**
+     * @brief Get a copy of the latest snapshot (writer side)
+     * 
+     * @return T the latest snapshot
+     */
+    T get() const
+    {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        return buffers[published.load()];
+    }
+
+    /**
+     * @brief Publish a new snapshot (writer side)
+     * 
+     * @param modifier callable applying the modifications to a copy of the latest snapshot.
+     * If it returns false the copy is discarded.
+     * @return the value returned by the modifier
+     */
+    template <typename Modifier>
+    bool update(Modifier modifier)
+    {
+        std::lock_guard<std::mutex> guard(writerMutex);
+        return publish(modifier);
+    }
+
+    /**
+     * @brief Publish a new snapshot only if no other writer is publishing, so that it can be called by the reader thread.
+     * Copying the snapshot does not allocate if the sizes of its containers do not change.
+     * 
+     * @param modifier callable applying the modifications to a copy of the latest snapshot.
+     * If it returns false the copy is discarded.
+     * @return false if another writer is publishing or if the modifier returns false, true otherwise
+     */
+    template <typename Modifier>
+    bool tryUpdate(Modifier modifier)
+    {
+        std::unique_lock<std::mutex> guard(writerMutex, std::try_to_lock);
+        if(!guard.owns_lock())
+            return false;
+        return publish(modifier);
+    }
+
+private:
+
+    static constexpr int NONE = -1;
+
+    T buffers[3];
+    std::atomic<int> published{0};
+    std::atomic<int> reading{NONE};
+    mutable std::mutex writerMutex;
+
+    // Copy the latest snapshot in a free buffer, modify it and publish it, the writer mutex must be locked
+    template <typename Modifier>
+    bool publish(Modifier& modifier)
+    {
+        const int current = published.load();
+        const int busy = reading.load();
+
+        // with three buffers there is always one which is neither published nor being read
+        int target = 0;
+        while(target==current || target==busy)
+            target++;
+
+        buffers[target] = buffers[current];
+        if(!modifier(buffers[target]))
+            return false;
+
+        published.store(target);
+        return true;
+    }
+};
+
+#endif // WEIGHT_RETARGETING_SNAPSHOT_BUFFER_H
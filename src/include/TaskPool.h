@@ -0,0 +1,81 @@
+#ifndef WEIGHT_RETARGETING_TASK_POOL_H
+#define WEIGHT_RETARGETING_TASK_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Small pool of threads running the tasks of a job together with the calling thread.
+ * Each job is a new generation, whose tasks are taken by the threads one at a time.
+ * The pool can be shared by several users, as long as the jobs are run by a single thread.
+ */
+class TaskPool
+{
+public:
+
+    /**
+     * @brief Job made of independent tasks identified by their index
+     */
+    class Job
+    {
+    public:
+
+        virtual ~Job() = default;
+
+        virtual void runTask(const size_t task) = 0;
+    };
+
+    TaskPool() = default;
+
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief Start the threads of the pool
+     *
+     * @param numberOfThreads the number of threads running the tasks, including the calling one
+     */
+    void start(const size_t numberOfThreads);
+
+    /**
+     * @brief Stop the threads of the pool, the jobs are then run by the calling thread only
+     */
+    void stop();
+
+    size_t getNumberOfThreads() const { return workers.size()+1; }
+
+    /**
+     * @brief Run the tasks of a job, returning once all of them have been run.
+     * It must be called by a single thread.
+     *
+     * @param job the job
+     * @param numberOfTasks the number of tasks of the job
+     */
+    void run(Job& job, const size_t numberOfTasks);
+
+private:
+
+    std::vector<std::thread> workers;
+    std::mutex poolMutex;
+    std::condition_variable jobStarted;
+    std::condition_variable jobCompleted;
+    size_t generation{0};
+    size_t nextTask{0};
+    size_t completedTasks{0};
+    size_t currentTasks{0};
+    bool stopping{false};
+    Job* currentJob{nullptr};
+
+    // Take the tasks of the current generation until all of them have been taken, the pool mutex must be locked
+    void runTasks(std::unique_lock<std::mutex>& lock);
+
+    void runWorker();
+};
+
+#endif // WEIGHT_RETARGETING_TASK_POOL_H
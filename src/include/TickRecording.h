@@ -0,0 +1,132 @@
+#ifndef WEIGHT_RETARGETING_TICK_RECORDING_H
+#define WEIGHT_RETARGETING_TICK_RECORDING_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Header of a tick recording file, followed by fixed-width records of
+ * (time, values[numberOfValues], velocities[numberOfVelocities]), all stored as native doubles.
+ * The header is a multiple of 8 bytes, so that the records of a memory-mapped file are aligned.
+ */
+struct TickRecordingHeader
+{
+    enum class Source : uint32_t
+    {
+        Retargeting = 0, // the values are the interface values of the joints
+        Display = 1 // the values are the wrenches of the inputs, NaN if a wrench is not available
+    };
+
+    static constexpr char MAGIC[8] = {'W','R','T','I','C','K','S','\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    // Number of values recorded for each input wrench of a display recording
+    static constexpr uint32_t WRENCH_SIZE = 6;
+
+    char magic[8];
+    uint32_t version;
+    Source source;
+    uint32_t numberOfValues;
+    uint32_t numberOfVelocities;
+
+    size_t getRecordSize() const { return (1+numberOfValues+numberOfVelocities)*sizeof(double); }
+};
+
+/**
+ * @brief Writer of a tick recording file.
+ * The records are written through the buffered stream of the C library, so writing a tick does not allocate.
+ */
+class TickRecorder
+{
+public:
+
+    ~TickRecorder();
+
+    /**
+     * @brief Create the recording file and write its header
+     *
+     * @param path the path of the file, overwritten if it exists
+     * @param source the source of the recorded values
+     * @param numberOfValues the number of values of each tick
+     * @param numberOfVelocities the number of velocities of each tick
+     * @return true if the file was created
+     * @return false otherwise
+     */
+    bool open(const std::string& path, const TickRecordingHeader::Source source, const size_t numberOfValues, const size_t numberOfVelocities);
+
+    /**
+     * @brief Append the record of a tick
+     *
+     * @param time the time of the tick in seconds
+     * @param values the values of the tick (size: numberOfValues)
+     * @param velocities the velocities of the tick (size: numberOfVelocities), nullptr to record zeros
+     * @return true if the record was written
+     * @return false otherwise
+     */
+    bool write(const double time, const double* values, const double* velocities);
+
+    /**
+     * @brief Flush and close the recording file
+     */
+    void close();
+
+    bool isOpen() const { return file!=nullptr; }
+
+private:
+
+    std::FILE* file{nullptr};
+    TickRecordingHeader header{};
+};
+
+/**
+ * @brief Read-only view of a tick recording file.
+ * The file is memory-mapped when the platform supports it, otherwise it is loaded in memory.
+ */
+class TickRecording
+{
+public:
+
+    TickRecording() = default;
+    TickRecording(const TickRecording&) = delete;
+    TickRecording& operator=(const TickRecording&) = delete;
+    ~TickRecording();
+
+    /**
+     * @brief Open a recording file and check its header
+     *
+     * @param path the path of the file
+     * @param error the reason of the failure
+     * @return true if the file is a valid recording
+     * @return false otherwise
+     */
+    bool open(const std::string& path, std::string& error);
+
+    const TickRecordingHeader& getHeader() const { return *reinterpret_cast<const TickRecordingHeader*>(data); }
+
+    size_t size() const { return numberOfTicks; }
+
+    double getTime(const size_t tick) const { return getRecord(tick)[0]; }
+
+    const double* getValues(const size_t tick) const { return getRecord(tick)+1; }
+
+    const double* getVelocities(const size_t tick) const { return getRecord(tick)+1+getHeader().numberOfValues; }
+
+private:
+
+    const unsigned char* data{nullptr};
+    size_t dataSize{0};
+    size_t numberOfTicks{0};
+    bool mapped{false};
+    std::vector<double> loadedData; // used when the file is not memory-mapped
+
+    const double* getRecord(const size_t tick) const
+    {
+        return reinterpret_cast<const double*>(data+sizeof(TickRecordingHeader)+tick*getHeader().getRecordSize());
+    }
+
+    void release();
+};
+
+#endif // WEIGHT_RETARGETING_TICK_RECORDING_H
@@ -0,0 +1,84 @@
+#ifndef WEIGHT_RETARGETING_TRIPLE_BUFFER_H
+#define WEIGHT_RETARGETING_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/**
+ * @brief Lock-free buffer passing the latest value from a single producer thread to a single consumer thread.
+ * The producer and the consumer own one buffer each, and exchange it with the third one through an atomic index,
+ * so that neither of them ever blocks or copies the data.
+ */
+template <typename T>
+class TripleBuffer
+{
+public:
+
+    /**
+     * @brief Initialize all of the buffers, it must be called before starting the threads
+     * 
+     * @param value the initial value
+     */
+    void initialize(const T& value)
+    {
+        for(T& buffer : buffers)
+            buffer = value;
+        writeIndex = 0;
+        readIndex = 1;
+        middle.store(2, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the buffer to be filled by the producer
+     * 
+     * @return T& the buffer owned by the producer
+     */
+    T& getWriteBuffer()
+    {
+        return buffers[writeIndex];
+    }
+
+    /**
+     * @brief Publish the write buffer as the latest value (producer side)
+     */
+    void publish()
+    {
+        writeIndex = middle.exchange(writeIndex | NEW_DATA, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    /**
+     * @brief Take the latest published value, if any (consumer side)
+     * 
+     * @return true if a new value has been published since the last call
+     * @return false otherwise
+     */
+    bool update()
+    {
+        if(!(middle.load(std::memory_order_relaxed) & NEW_DATA))
+            return false;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Get the latest value taken by the consumer
+     * 
+     * @return const T& the buffer owned by the consumer
+     */
+    const T& getReadBuffer() const
+    {
+        return buffers[readIndex];
+    }
+
+private:
+
+    static constexpr int NEW_DATA = 4;
+    static constexpr int INDEX_MASK = 3;
+
+    T buffers[3];
+    int writeIndex{0};
+    int readIndex{1};
+    std::atomic<int> middle{2};
+};
+
+#endif // WEIGHT_RETARGETING_TRIPLE_BUFFER_H
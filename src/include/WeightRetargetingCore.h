@@ -0,0 +1,590 @@
+#ifndef WEIGHT_RETARGETING_CORE_H
+#define WEIGHT_RETARGETING_CORE_H
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <yarp/os/Searchable.h>
+
+#include "GroupFilter.h"
+#include "GroupPredictor.h"
+#include "IntensityCurve.h"
+#include "RetargetingKernel.h"
+#include "SnapshotBuffer.h"
+
+/**
+ * @brief Retargeting logic of the WeightRetargetingModule.
+ * It maps the values measured on the joints (data in) to the haptic actuation commands (commands out)
+ * and it does not depend on the YARP network or on the control boards.
+ */
+class WeightRetargetingCore
+{
+public:
+
+    /**
+     * @brief Contiguous table of the actuator groups, in the order of the configuration.
+     * The joints and actuators of the group i are the spans [jointOffsets[i], jointOffsets[i+1])
+     * and [actuatorOffsets[i], actuatorOffsets[i+1]) of the jointIndexes and actuators arrays.
+     * The table does not change after the configuration.
+     */
+    struct ActuatorGroupTable
+    {
+        std::vector<std::string> names;
+        std::vector<int> jointOffsets{0};
+        std::vector<int> jointIndexes;
+        std::vector<int> actuatorOffsets{0};
+        std::vector<std::string> actuators; // full names of the actuators, resolved once while reading the configuration
+
+        size_t size() const { return names.size(); }
+    };
+
+    /**
+     * @brief Parameters of the actuator groups that can be changed at runtime, the value of the group i is at index i
+     */
+    struct GroupParameters
+    {
+        std::vector<double> minThresholds;
+        std::vector<double> maxThresholds;
+        std::vector<double> offsets;
+    };
+
+    struct ActuationCommand
+    {
+        const std::string* actuator; // full name of the actuator, owned by the group table
+        double intensity;
+    };
+
+    /**
+     * @brief Stages of the control cycle specialized at compile time for a fixed layout of the groups (see RetargetingPipeline).
+     * The generic stages are used for the ones that are not set.
+     */
+    struct SpecializedStages
+    {
+        std::string layout; // name of the layout
+        void (*computeNorms)(const double* interfaceValues, double* groupNorms){nullptr};
+        void (*checkVelocities)(const double* velocities, const double maxVelocity, std::vector<bool>& allowedGroups){nullptr};
+    };
+
+    /**
+     * @brief State of the offset calibration, shared between the RPC and the control cycle
+     */
+    enum class CalibrationState
+    {
+        Idle,
+        Requested, // written by the RPC
+        Collecting, // the control cycle is collecting the norms
+        Committing // the control cycle is publishing the offsets
+    };
+
+    // Robust estimate of the baseline norm of a group from the collected samples
+    enum class CalibrationEstimator
+    {
+        Mean,
+        Median,
+        Invalid
+    };
+
+    const std::string LOG_PREFIX = "RetargetingCore";
+
+    const std::string IFEEL_SUIT_ACTUATOR_PREFIX = "iFeelSuit::haptic::Node#";
+
+    // Name of the axis of the actuator groups retargeting the weight held by the end effectors, instead of a joint
+    const std::string WEIGHT_AXIS_NAME = "weight";
+
+    // Number of configuration parameters defining an actuator group
+    const size_t CONFIG_GROUP_SIZE = 5;
+
+    // Number of configuration parameters defining a group filter
+    const size_t CONFIG_FILTER_SIZE = 3;
+
+    // Minimum number of configuration parameters defining an intensity curve
+    const size_t CONFIG_CURVE_MIN_SIZE = 2;
+
+    // Velocity check parameters
+    bool useVelocities = false;
+    double maxJointVelocity = 0.35;
+
+    // Minimum actuation intensity to be sent
+    double minIntensity = 0.0;
+
+    // Delta output: a command is sent only if the intensity of the actuator changes or the keep-alive period expires,
+    // and an explicit zero is sent when the intensity drops below minIntensity
+    bool deltaOutput = false;
+    double keepAlivePeriod = 1.0; // [s]
+    std::vector<double> lastSentIntensities; // last intensity sent to each actuator
+    std::vector<double> lastSentTimes; // time of the last command sent to each actuator
+    size_t suppressedCommands = 0; // number of commands not sent thanks to the delta output
+
+    std::vector<std::string> jointNames;
+    // The weight is retargeted by some groups, as the value after the ones of the joints
+    bool useWeight = false;
+    ActuatorGroupTable groups;
+    std::unordered_map<std::string,size_t> groupIndexMap; // group name to index in the table, used only by the RPC
+
+    // Parameters read by the control cycle without locking and updated by the RPC
+    SnapshotBuffer<GroupParameters> parameters;
+
+    // Offset calibration: the RPC requests the calibration of some groups, the control cycle collects their norms
+    // in a preallocated window, estimates the baseline and publishes the offsets without waiting for the RPC
+    int calibrationSamples = 50; // maximum number of samples of a calibration
+    double calibrationDuration = 0.0; // [s] maximum duration of a calibration, 0 to use only the number of samples
+    CalibrationEstimator calibrationEstimator = CalibrationEstimator::Median;
+    std::atomic<CalibrationState> calibrationState{CalibrationState::Idle};
+    std::atomic<int> calibrationRequestedGroup{-1}; // index of the group to be calibrated, -1 for all of the groups
+    std::atomic<int> calibrationCollectedSamples{0}; // samples collected by the current or by the last calibration
+    int calibrationGroup = -1; // group being calibrated by the control cycle
+    double calibrationStartTime = 0.0;
+    std::vector<double> calibrationWindow; // samples of the group i in [i*calibrationSamples, (i+1)*calibrationSamples)
+    std::vector<double> calibrationEstimates; // baseline norms waiting to be published
+
+    // Batch computation of the intensities of all of the groups
+    RetargetingKernel kernel;
+    std::vector<double> groupNorms;
+    std::vector<double> intensities;
+
+    // Filter stage applied to the norms of the groups, the filter of the group i is at index i
+    std::vector<GroupFilter> filters;
+
+    // Predictor stage extrapolating the filtered norms of the groups ahead of the joint sample, by the age
+    // of the sample and by the latency after the generation of the commands (transport and suit)
+    GroupPredictor::Type predictorType = GroupPredictor::Type::None;
+    double predictionHorizon = 0.0; // [s] latency after the generation of the commands
+    int predictionWindow = 5; // samples of the linear predictor
+    double predictionProcessNoise = 1.0; // [norm^2/s^3] of the Kalman predictor
+    double predictionMeasurementNoise = 0.01; // [norm^2] of the Kalman predictor
+    std::vector<GroupPredictor> predictors;
+    std::vector<double> predictedNorms;
+    double predictionLead = 0.0; // [s] lead of the latest prediction, capped to twice the horizon
+
+    // Curves mapping the norms of the groups to the intensities, the curve of the group i is at index i.
+    // The control cycle reads them without locking, the RPC compiles the new curves and publishes them.
+    SnapshotBuffer<std::vector<IntensityCurve>> curves;
+
+    // Hysteresis on the on/off decision: a group turns on above minIntensity+band and turns off below minIntensity-band
+    std::vector<double> hysteresisBands;
+    std::vector<bool> groupActive; // on/off state of each group
+
+    // Result of the velocity check of each group
+    std::vector<bool> groupVelocityAllowed;
+
+    // Stages specialized for the layout of the groups, set after the configuration by selectSpecializedStages
+    SpecializedStages specializedStages;
+
+    /**
+     * @brief Get the index of an actuator group in the group table
+     * 
+     * @param actuatorGroup the name of the group
+     * @param index the index of the group
+     * @return true if the group exists
+     * @return false otherwise
+     */
+    bool getGroupIndex(const std::string& actuatorGroup, size_t& index) const;
+
+    /**
+     * @brief Get the number of the retargeted values, that is the joints followed by the weight if it is used
+     * 
+     * @return size_t the size of the values and of the velocities given to the control cycle
+     */
+    size_t getNumberOfValues() const { return jointNames.size() + (useWeight ? 1 : 0); }
+
+    static std::string calibrationStateToString(const CalibrationState state);
+
+    static CalibrationEstimator calibrationEstimatorFromString(const std::string& name);
+
+    /**
+     * @brief Get the square norms of the retargeted interface of an actuator group
+     * 
+     * @param group the index of the actuators group
+     * @param interfaceValues the values measured on the joints
+     * @return double the norm of the read measurements
+     */
+    double getNorm(const size_t group, const std::vector<double>& interfaceValues) const;
+
+    /**
+     * @brief Maps a measured value to the actuation command value
+     * 
+     * @param measuredValue the measured value
+     * @param minThreshold the value mapped to the null intensity
+     * @param maxThreshold the value mapped to the maximum intensity
+     * @return double the value of the actuation command
+     */
+    static double computeActuationIntensity(const double measuredValue, const double minThreshold, const double maxThreshold);
+
+    /**
+     * @brief Check the max velocity constraint for an actuator group
+     * 
+     * @param group the index of the group to check
+     * @param velocities the velocities of the joints
+     * @return true if none of the related joints' velocity is above threshold
+     * @return false otherwise
+     */
+    bool checkGroupVelocity(const size_t group, const std::vector<double>& velocities) const;
+
+    /**
+     * @brief Computes the actuation command value of a single group.
+     * It gives the same result of the batch kernel used by generateGroupsActuation when the group is not filtered and its curve is linear.
+     * 
+     * @param group the index of the actuators group
+     * @param groupParameters the parameters of the groups
+     * @param interfaceValues the values measured on the joints
+     * @param velocities the velocities of the joints (used only if the velocity check is enabled)
+     * @return double the value of the actuation command
+     */
+    double computeActuationIntensity(const size_t group, const GroupParameters& groupParameters, const std::vector<double>& interfaceValues, const std::vector<double>& velocities) const;
+
+    /**
+     * @brief Read the parameters of the retargeting, the actuator groups and their filters
+     * 
+     * @param config the configuration of the module
+     * @return true if the reading was successful
+     * @return false otherwise
+     */
+    bool configure(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Retrieve data related to actuators groups from configuration and build the group table
+     * 
+     * @param config the configuration containing the actuator_groups parameter
+     * @return true if the reading was successful
+     * @return false otherwise
+     */
+    bool readActuatorsGroups(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Retrieve the filters of the actuator groups from the optional group_filters parameter.
+     * It must be called after readActuatorsGroups.
+     * 
+     * @param config the configuration containing the group_filters parameter
+     * @return true if the parameter is missing or valid
+     * @return false otherwise
+     */
+    bool readGroupFilters(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Retrieve the intensity curves of the actuator groups from the optional group_curves parameter.
+     * It must be called after readActuatorsGroups.
+     * 
+     * @param config the configuration containing the group_curves parameter
+     * @return true if the parameter is missing or valid
+     * @return false otherwise
+     */
+    bool readIntensityCurves(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Retrieve the parameters of the predictor of the norms from the optional predictor parameters.
+     * It must be called after readActuatorsGroups.
+     * 
+     * @param config the configuration containing the predictor parameters
+     * @return true if the parameters are missing or valid
+     * @return false otherwise
+     */
+    bool readPredictor(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Generates the actuation commands for all of the configured groups, using the batch kernel.
+     * It reads the latest snapshot of the parameters without locking.
+     * 
+     * @param interfaceValues the values measured on the joints
+     * @param velocities the velocities of the joints (used only if the velocity check is enabled)
+     * @param time the time of the measurements in seconds (used only by the delta output)
+     * @param commands the generated commands, one for each actuator to be actuated.
+     * No allocation is made if its capacity is at least the number of actuators.
+     */
+    void generateGroupsActuation(const std::vector<double>& interfaceValues, const std::vector<double>& velocities, const double time, std::vector<ActuationCommand>& commands);
+
+    /**
+     * @brief Generates the actuation commands for all of the configured groups, predicting the norms from the
+     * timestamp of the joint sample if the predictor is enabled.
+     * 
+     * @param interfaceValues the values measured on the joints
+     * @param velocities the velocities of the joints (used only if the velocity check is enabled)
+     * @param time the current time in seconds
+     * @param measurementTime the timestamp of the joint sample in seconds
+     * @param commands the generated commands, one for each actuator to be actuated.
+     * No allocation is made if its capacity is at least the number of actuators.
+     */
+    void generateGroupsActuation(const std::vector<double>& interfaceValues, const std::vector<double>& velocities, const double time, const double measurementTime, std::vector<ActuationCommand>& commands);
+
+    /**
+     * @brief Set the max threshold of a group, publishing a new snapshot of the parameters
+     * 
+     * @param actuatorGroup the name of the group
+     * @param value the value of the threshold
+     * @return true if the group exists
+     * @return false otherwise
+     */
+    bool setMaxThreshold(const std::string& actuatorGroup, const double value);
+
+    /**
+     * @brief Set the min threshold of a group, publishing a new snapshot of the parameters
+     * 
+     * @param actuatorGroup the name of the group
+     * @param value the value of the threshold
+     * @return true if the group exists
+     * @return false otherwise
+     */
+    bool setMinThreshold(const std::string& actuatorGroup, const double value);
+
+    /**
+     * @brief Set the thresholds of a group, publishing a new snapshot of the parameters
+     * 
+     * @param actuatorGroup the name of the group
+     * @param minThreshold the value of the min threshold
+     * @param maxThreshold the value of the max threshold
+     * @return true if the group exists
+     * @return false otherwise
+     */
+    bool setThresholds(const std::string& actuatorGroup, const double minThreshold, const double maxThreshold);
+
+    /**
+     * @brief Set the intensity curve of a group, compiling it and publishing a new snapshot of the curves
+     * 
+     * @param actuatorGroup the name of the group, or all for all of the groups
+     * @param curveName the name of the curve
+     * @param curveParameters the parameters of the curve (see IntensityCurve::configure)
+     * @return true if the group exists and the curve is valid
+     * @return false otherwise
+     */
+    bool setIntensityCurve(const std::string& actuatorGroup, const std::string& curveName, const std::vector<double>& curveParameters);
+
+    /**
+     * @brief Request the calibration of the offset of a group (RPC side), without waiting for it.
+     * The control cycle estimates the baseline norm of the group over the calibration window
+     * and sets the offset so that it is mapped to the min threshold of the group.
+     * 
+     * @param actuatorGroup the name of the group, all for all of the groups
+     * @return true if the group exists and no other calibration is in progress
+     * @return false otherwise
+     */
+    bool removeOffset(const std::string& actuatorGroup);
+
+    /**
+     * @brief Advance the calibration in progress (control cycle side), it never blocks.
+     * The offsets are published only if no RPC is updating the parameters, otherwise they are retried at the next call.
+     * 
+     * @param norms the filtered norms of the groups
+     * @param time the time of the norms in seconds
+     */
+    void updateCalibration(const std::vector<double>& norms, const double time);
+
+    /**
+     * @brief Estimate the baseline of a window of samples, the order of the samples is not preserved
+     * 
+     * @param samples the samples
+     * @param size the number of samples, at least 1
+     * @return double the estimated baseline
+     */
+    double estimateBaseline(double* samples, const size_t size) const;
+};
+
+/**
+ * @brief Weight computation logic of the WeightDisplayModule.
+ * It maps the wrenches measured on the end effectors to the weight of the held object.
+ */
+class WeightDisplayCore
+{
+public:
+
+    // Force and torque of a wrench
+    using Wrench = std::array<double, 6>;
+
+    /**
+     * @brief Parameters that can be changed at runtime, the offset of the input i is at index i
+     */
+    struct DisplayParameters
+    {
+        std::vector<Wrench> offsets; // bias of the wrenches in their own frame, removed before any other computation
+        double minWeight{0.0}; // minimum weight to be displayed in kilograms
+    };
+
+    /**
+     * @brief State of the tare calibration, shared between the RPC and the tick
+     */
+    enum class TareState
+    {
+        Idle,
+        Requested, // written by the RPC
+        Collecting, // the tick is collecting the wrenches
+        Committing // the tick is publishing the offsets
+    };
+
+    // Outcome of the last tare calibration
+    enum class TareResult
+    {
+        None,
+        Succeeded,
+        Rejected, // the force was not steady enough
+        TimedOut // not enough wrenches were received
+    };
+
+    const std::string LOG_PREFIX = "DisplayCore";
+
+    const double GRAVITY_ACCELERATION = 9.81;
+
+    // Names of the input wrenches
+    std::vector<std::string> inputNames;
+
+    // Parameters read by the tick without locking and updated by the RPC
+    SnapshotBuffer<DisplayParameters> parameters;
+
+    // Tare calibration: the RPC requests the calibration of some inputs, the tick collects the new wrenches,
+    // computes their statistics and publishes the offsets without waiting for the RPC
+    int tareSamples = 50; // number of samples averaged by a tare
+    double tareMaxDeviation = 0.0; // maximum standard deviation of the force for a tare to be valid in N, 0 to disable the check
+    double tareTimeout = 5.0; // [s] maximum duration of a tare
+    std::atomic<TareState> tareState{TareState::Idle};
+    std::atomic<TareResult> tareResult{TareResult::None};
+    std::atomic<int> tareRequestedInput{-1}; // index of the input to be calibrated, -1 for all of the inputs
+    std::atomic<int> tareCollectedSamples{0}; // samples collected by the slowest input of the current or of the last tare
+    int tareInput = -1; // input being calibrated by the tick
+    double tareStartTime = 0.0;
+    std::vector<int> tareCounts; // number of samples collected for each input
+    std::vector<Wrench> tareSums; // sum of the samples of each input
+    std::vector<Wrench> tareSquareSums; // sum of the squared samples of each input
+    std::vector<double> tareSampleTimes; // timestamp of the last sample collected for each input
+    std::vector<Wrench> tareMeans; // offsets waiting to be published
+
+    // Velocity check parameters
+    bool useVelocity = false;
+    double maxVelocity = 0.0;
+
+    // Names of the joints whose velocity is checked
+    std::vector<std::string> jointAxes;
+
+    // Indexes of the joints related to each input wrench
+    std::vector<std::vector<int>> inputJoints;
+
+    /**
+     * @brief Read the input names, the calibration parameters and the velocity check parameters
+     * 
+     * @param config the configuration containing the input_port_names parameter and the optional VELOCITY_UTILS group
+     * @return true if the reading was successful
+     * @return false otherwise
+     */
+    bool configure(const yarp::os::Searchable& config);
+
+    /**
+     * @brief Get the index of an input
+     * 
+     * @param input the name of the input
+     * @param index the index of the input
+     * @return true if the input exists
+     * @return false otherwise
+     */
+    bool getInputIndex(const std::string& input, size_t& index) const;
+
+    /**
+     * @brief Remove the offsets from the wrenches of the inputs, using the latest snapshot of the parameters without locking
+     * 
+     * @param wrenches the wrenches of the inputs, nullptr if a wrench is not available, replaced with the compensated wrenches
+     * @param compensatedWrenches the storage of the compensated wrenches, with one element for each input
+     * @return double the minimum weight to be displayed
+     */
+    double removeOffsets(std::vector<const double*>& wrenches, std::vector<Wrench>& compensatedWrenches);
+
+    static std::string tareStateToString(const TareState state);
+
+    static std::string tareResultToString(const TareResult result);
+
+    /**
+     * @brief Request the tare of an input (RPC side), without waiting for it.
+     * The tick collects tare_samples new wrenches of the input and publishes their mean as its offset.
+     * 
+     * @param input the name of the input, all for all of the inputs
+     * @return true if the input exists and no other tare is in progress
+     * @return false otherwise
+     */
+    bool requestTare(const std::string& input);
+
+    /**
+     * @brief Advance the tare in progress (tick side), it never blocks.
+     * A wrench is collected only if its timestamp is newer than the one of the last sample of its input,
+     * so that the ticks without a new wrench on an input do not weight its latest sample more.
+     * The offsets are published only if no RPC is updating the parameters, otherwise they are retried at the next call.
+     * 
+     * @param wrenches the wrenches of the inputs before the offset removal, nullptr if a wrench is not available
+     * @param wrenchTimes the timestamps of the wrenches of the inputs
+     * @param time the current time in seconds, used for the timeout
+     */
+    void updateTare(const std::vector<const double*>& wrenches, const std::vector<double>& wrenchTimes, const double time);
+
+    /**
+     * @brief Clear the offset of an input, publishing a new snapshot of the parameters
+     * 
+     * @param input the name of the input, all for all of the inputs
+     * @return true if the input exists
+     * @return false otherwise
+     */
+    bool clearTare(const std::string& input);
+
+    /**
+     * @brief Set the minimum weight to be displayed, publishing a new snapshot of the parameters
+     * 
+     * @param value the minimum weight in kilograms
+     * @return true
+     */
+    bool setMinWeight(const double value);
+
+    /**
+     * @brief Check the max velocity constraint for an input
+     * 
+     * @param input the index of the input wrench
+     * @param velocities the velocities of the joints
+     * @return true if none of the related joints' velocity is above threshold
+     * @return false otherwise
+     */
+    bool checkInputVelocity(const size_t input, const std::vector<double>& velocities) const;
+
+    /**
+     * @brief Convert an orientation to a rotation matrix
+     * 
+     * @param orientation the orientation, either a row-major rotation matrix (9 values) or a quaternion in the form w x y z (4 values)
+     * @param size the number of values of the orientation
+     * @param rotation the row-major rotation matrix
+     * @return true if the size of the orientation is valid
+     * @return false otherwise
+     */
+    static bool orientationToRotation(const double* orientation, const size_t size, double* rotation);
+
+    /**
+     * @brief Rotate the force and the torque of a wrench
+     * 
+     * @param rotation the row-major rotation matrix from the frame of the wrench to the gravity frame
+     * @param wrench the wrench to be rotated
+     * @param rotatedWrench the wrench expressed in the gravity frame
+     */
+    static void rotateWrench(const double* rotation, const double* wrench, double* rotatedWrench)
+    {
+        for(int row=0; row<3; row++)
+        {
+            const double* r = rotation+3*row;
+            rotatedWrench[row] = r[0]*wrench[0] + r[1]*wrench[1] + r[2]*wrench[2];
+            rotatedWrench[3+row] = r[0]*wrench[3] + r[1]*wrench[4] + r[2]*wrench[5];
+        }
+    }
+
+    /**
+     * @brief Express the wrenches of all of the inputs in the gravity frame, whose z-axis is opposite to the gravity.
+     * The wrenches without a rotation are not available after the rotation.
+     * 
+     * @param rotations the row-major rotation matrices of the inputs, nullptr if the rotation of an input is not available
+     * @param wrenches the wrenches of the inputs, nullptr if a wrench is not available, replaced with the rotated wrenches
+     * @param rotatedWrenches the storage of the rotated wrenches, with one element for each input
+     */
+    static void rotateWrenches(const std::vector<const double*>& rotations, std::vector<const double*>& wrenches, std::vector<Wrench>& rotatedWrenches);
+
+    /**
+     * @brief Computes the weight held by the end effectors
+     * 
+     * @param wrenches the wrenches of the inputs expressed in a frame whose z-axis is opposite to the gravity,
+     * nullptr if the wrench of an input is not available
+     * @param velocities the velocities of the joints (used only if the velocity check is enabled)
+     * @return double the weight in kilograms
+     */
+    double computeWeight(const std::vector<const double*>& wrenches, const std::vector<double>& velocities) const;
+};
+
+#endif // WEIGHT_RETARGETING_CORE_H
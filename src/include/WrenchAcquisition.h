@@ -0,0 +1,217 @@
+#ifndef WEIGHT_RETARGETING_WRENCH_ACQUISITION_H
+#define WEIGHT_RETARGETING_WRENCH_ACQUISITION_H
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <yarp/os/BufferedPort.h>
+#include <yarp/os/Searchable.h>
+#include <yarp/sig/Vector.h>
+
+#include "WeightRetargetingCore.h"
+#include "WrenchTimeSeries.h"
+
+/**
+ * @brief Acquisition of the wrenches of the end effectors and of their orientations from the YARP ports,
+ * shared by the WeightDisplayModule and by the weight retargeted by the WeightRetargetingModule.
+ * The wrenches are decoded once in the time series of their inputs, which are read by the users of the acquisition.
+ */
+class WrenchAcquisition
+{
+public:
+
+    /**
+     * @brief Notified in the event-driven mode when a wrench arrives, with the mutex of the acquisition locked
+     */
+    class Listener
+    {
+    public:
+
+        virtual ~Listener() = default;
+
+        virtual void onWrench(const double time) = 0;
+    };
+
+    const std::string LOG_PREFIX = "WrenchAcquisition";
+
+    // The callbacks of the input ports run in different threads, the inputs must be read with the mutex locked
+    std::mutex mutex;
+
+    /**
+     * @brief Read the parameters of the acquisition and open the ports of the inputs
+     *
+     * @param config the configuration containing the optional staleness_window, orientation_port_names, time_alignment and alignment_buffer_size parameters
+     * @param inputNames the names of the inputs, one port is opened for each of them
+     * @param portPrefix the prefix of the ports
+     * @return true if the parameters are valid and the ports have been opened
+     * @return false otherwise
+     */
+    bool configure(const yarp::os::Searchable& config, const std::vector<std::string>& inputNames, const std::string& portPrefix);
+
+    /**
+     * @brief Store the wrenches as soon as they arrive and notify them, instead of waiting for read
+     *
+     * @param listener the listener, which must outlive the acquisition
+     */
+    void useCallbacks(Listener& listener);
+
+    /**
+     * @brief Stop the callbacks and close the ports
+     */
+    void close();
+
+    /**
+     * @brief Store the new wrenches received on the ports, the inputs without new data keep the previous ones.
+     * With the time alignment the ports are strict, so all of the wrenches received since the last call are stored.
+     * The mutex must be locked.
+     *
+     * @param time the current time
+     */
+    void read(const double time);
+
+    /**
+     * @brief Get the latest wrenches, interpolated at a common timestamp if the time alignment is enabled.
+     * The wrenches older than the staleness window are not available. The mutex must be locked.
+     *
+     * @param time the current time
+     * @param wrenches the wrenches of the inputs, nullptr if a wrench is not available, valid until the next call
+     * @return double the timestamp of the wrenches, that is the oldest among the newest timestamps of the inputs, or time if none is available
+     */
+    double getWrenches(const double time, std::vector<const double*>& wrenches);
+
+    /**
+     * @brief Get the timestamps of the newest wrenches of the inputs, which change only when a new wrench is stored.
+     * The mutex must be locked.
+     *
+     * @param times the timestamps of the inputs, NaN if no wrench has been received on an input
+     */
+    void getWrenchTimes(std::vector<double>& times) const;
+
+    /**
+     * @brief Read the latest orientations of the end effectors. The mutex must be locked.
+     *
+     * @param time the current time
+     * @param rotations the row-major rotation matrices of the inputs, nullptr if the orientation of an input has not been received within the staleness window
+     */
+    void getRotations(const double time, std::vector<const double*>& rotations);
+
+    // Whether the wrenches have to be rotated with the orientations of the end effectors, instead of assuming their z-axis vertical
+    bool useOrientation() const { return !orientationPorts.empty(); }
+
+    bool isTimeAligned() const { return timeAlignment; }
+
+    size_t getNumberOfInputs() const { return inputPorts.size(); }
+
+private:
+
+    // Callback of an input port, used in the event-driven mode
+    class WrenchCallback : public yarp::os::TypedReaderCallback<yarp::sig::Vector>
+    {
+    public:
+        WrenchCallback(WrenchAcquisition& acquisition, const size_t input) : acquisition(acquisition), input(input) {}
+
+        void onRead(yarp::sig::Vector& wrench) override
+        {
+            acquisition.onRead(input, wrench);
+        }
+
+    private:
+        WrenchAcquisition& acquisition;
+        size_t input;
+    };
+
+    // maximum age of a wrench to be used
+    double stalenessWindow = 0.1; // [s]
+
+    // interpolate the wrenches of all of the inputs to a common timestamp
+    bool timeAlignment = false;
+    int alignmentBufferSize = 16; // number of wrenches kept for each input
+
+    // input ports
+    std::vector<std::unique_ptr<yarp::os::BufferedPort<yarp::sig::Vector>>> inputPorts;
+    std::vector<std::unique_ptr<WrenchCallback>> inputCallbacks;
+    Listener* listener{nullptr};
+    std::vector<WrenchTimeSeries> inputSeries; // latest wrenches received on each input port
+    std::vector<WrenchTimeSeries::Wrench> alignedWrenches;
+
+    // orientation ports
+    std::vector<std::string> orientationPortNames;
+    std::vector<std::unique_ptr<yarp::os::BufferedPort<yarp::sig::Vector>>> orientationPorts;
+    std::vector<std::array<double, 9>> inputRotations; // latest rotation matrix of each input, row-major
+    std::vector<double> rotationArrivalTimes;
+
+    /**
+     * @brief Store the latest wrench of an input, the mutex must be locked.
+     * The wrench is timestamped with the envelope of the port, or with its arrival time if the envelope is not available.
+     *
+     * @param input the index of the input
+     * @param wrench the wrench read from the input
+     * @param time the arrival time of the wrench
+     */
+    void storeWrench(const size_t input, const yarp::sig::Vector& wrench, const double time);
+
+    // Called in the event-driven mode when a wrench arrives on an input port
+    void onRead(const size_t input, const yarp::sig::Vector& wrench);
+};
+
+/**
+ * @brief Weight held by the end effectors, computed from the wrenches of its own acquisition
+ * so that it is retargeted by the actuator groups together with the values of the joints.
+ * Alternatively it is read from the weight published by a WeightDisplayModule, so that the wrenches are read only once.
+ * It is updated by the acquisition thread of the WeightRetargetingModule, once for all of its instances.
+ */
+class WeightAcquisition
+{
+public:
+
+    const std::string LOG_PREFIX = "WeightAcquisition";
+
+    /**
+     * @brief Read the inputs and open their ports, or open the port of the published weight
+     *
+     * @param config the configuration containing either the weight_port_name parameter with the optional staleness_window,
+     * or the input_port_names parameter and the parameters of the WrenchAcquisition
+     * @param portPrefix the prefix of the ports
+     * @return true if the configuration is valid and the ports have been opened
+     * @return false otherwise
+     */
+    bool configure(const yarp::os::Searchable& config, const std::string& portPrefix);
+
+    void close();
+
+    /**
+     * @brief Read the new wrenches and compute the weight, called by a single thread
+     */
+    void update();
+
+    // Latest weight in kilograms, read by the thread calling update
+    double getWeight() const { return weight; }
+
+    // Timestamp of the wrenches of the latest weight in seconds
+    double getMeasurementTime() const { return measurementTime; }
+
+private:
+
+    // weight published by a WeightDisplayModule, used instead of the wrenches if the port is open
+    bool readPublishedWeight{false};
+    yarp::os::BufferedPort<yarp::sig::Vector> weightPort;
+    double stalenessWindow{0.1}; // [s]
+    double weightArrivalTime{0.0};
+
+    WeightDisplayCore core;
+    WrenchAcquisition wrenchAcquisition;
+    std::vector<const double*> wrenches;
+    std::vector<const double*> rotations;
+    std::vector<WeightDisplayCore::Wrench> rotatedWrenches;
+    std::vector<double> velocities; // the velocities are checked by the actuator groups
+    double weight{0.0};
+    double measurementTime{0.0};
+
+    // Read the latest weight published on the port, the weight is zero if it is older than the staleness window
+    void readWeight(const double time);
+};
+
+#endif // WEIGHT_RETARGETING_WRENCH_ACQUISITION_H
@@ -0,0 +1,76 @@
+#ifndef WEIGHT_RETARGETING_WRENCH_TIME_SERIES_H
+#define WEIGHT_RETARGETING_WRENCH_TIME_SERIES_H
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Bounded history of the wrenches received on an input, ordered by timestamp.
+ * The ring buffer is allocated by configure, so that adding a wrench never allocates,
+ * and the wrench at any timestamp covered by the history is linearly interpolated.
+ */
+class WrenchTimeSeries
+{
+public:
+
+    static constexpr size_t WRENCH_SIZE = 6;
+
+    using Wrench = std::array<double, WRENCH_SIZE>;
+
+    /**
+     * @brief Allocate the ring buffer and clear the history
+     *
+     * @param capacity the maximum number of wrenches kept, at least 1
+     */
+    void configure(const size_t capacity);
+
+    /**
+     * @brief Add a wrench to the history, overwriting the oldest one if the buffer is full.
+     * A wrench older than the newest one is discarded without updating the arrival time,
+     * a wrench with the same timestamp replaces it.
+     *
+     * @param time the timestamp of the wrench
+     * @param wrench the values of the wrench, the missing ones are set to zero
+     * @param size the number of values of the wrench
+     * @param arrivalTime the local time at which the wrench has been received
+     */
+    void push(const double time, const double* wrench, const size_t size, const double arrivalTime);
+
+    bool empty() const { return count==0; }
+
+    size_t size() const { return count; }
+
+    double getNewestTime() const { return times[getSlot(count-1)]; }
+
+    double getOldestTime() const { return times[getSlot(0)]; }
+
+    const Wrench& getNewest() const { return wrenches[getSlot(count-1)]; }
+
+    // Local time at which the last stored wrench has been received
+    double getLastArrivalTime() const { return lastArrivalTime; }
+
+    /**
+     * @brief Get the wrench at a timestamp, linearly interpolated between the two nearest wrenches.
+     * Outside of the history the oldest or the newest wrench is used.
+     *
+     * @param time the timestamp
+     * @param wrench the interpolated wrench
+     * @return true if the history is not empty
+     * @return false otherwise
+     */
+    bool interpolate(const double time, Wrench& wrench) const;
+
+private:
+
+    std::vector<double> times;
+    std::vector<Wrench> wrenches;
+    size_t first{0}; // slot of the oldest wrench
+    size_t count{0};
+    double lastArrivalTime{0.0};
+
+    // slot of the i-th oldest wrench
+    size_t getSlot(const size_t i) const { return (first+i)%times.size(); }
+};
+
+#endif // WEIGHT_RETARGETING_WRENCH_TIME_SERIES_H
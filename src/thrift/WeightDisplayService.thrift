@@ -0,0 +1,45 @@
+
+/**
+ * Progress of the tare started by tare
+ */
+struct TareStatus {
+    1: string state;
+    2: string input;
+    3: i32 collectedSamples;
+    4: i32 maxSamples;
+    5: string result;
+}
+
+/**
+ * Definition of the WeightDisplay RPC service
+ */
+service WeightDisplayService {
+
+    /**
+     * Start the removal of the bias of the wrench of an input, without waiting for it.
+     * The offset is the mean of the next tare_samples wrenches received on the input.
+     * The name all can be used to calibrate all of the inputs. The robot must not hold any object.
+     * @return true if the tare has started, false if the input does not exist or another tare is in progress
+     */
+    bool tare(1: string input);
+
+    /**
+     * Get the progress of the tare.
+     * If no tare is in progress, the state is idle and the other fields refer to the last tare.
+     * @return the status of the tare
+     */
+    TareStatus getTareStatus();
+
+    /**
+     * Clear the offset of the wrench of an input.
+     * The name all can be used to clear the offsets of all of the inputs.
+     * @return true if the procedure was successful, false otherwise
+     */
+    bool clearTare(1: string input);
+
+    /**
+     * Set the minimum weight to be displayed
+     * @return true if the procedure was successful, false otherwise
+     */
+    bool setMinWeight(1: double value);
+}
@@ -1,4 +1,26 @@
 
+/**
+ * Latency statistics of a stage of the retargeting, in seconds
+ */
+struct LatencyStageStats {
+    1: string stage;
+    2: i64 count;
+    3: double p50;
+    4: double p99;
+    5: double p999;
+    6: double max;
+}
+
+/**
+ * Progress of the offset calibration started by removeOffset
+ */
+struct CalibrationStatus {
+    1: string state;
+    2: string actuatorGroup;
+    3: i32 collectedSamples;
+    4: i32 maxSamples;
+}
+
 /**
  * Definition of the WeightRetargeting RPC service
  */
@@ -23,9 +45,65 @@ service WeightRetargetingService {
     bool setThresholds(1: string actuatorGroup, 2: double minThreshold, 3: double maxThreshold);
 
     /**
-     * Remove the offset of an actuators group.
+     * Set the curve mapping the norm of an actuators group to the intensity between the min and max thresholds:
+     * linear, power (exponent), log (gain), steps (number of steps) or piecewise (x y pairs of the normalized points).
+     * The name all can be used to set the curve of all of the actuators group.
+     * @return true if the procedure was successful, false if the group does not exist or the curve is not valid
+     */
+    bool setIntensityCurve(1: string actuatorGroup, 2: string curve, 3: list<double> parameters);
+
+    /**
+     * Start the calibration of the offset of an actuators group, without waiting for it.
      * The name all can be used to remove the offset of all of the actuators group.
-     * @return true if the procedure was successful, false otherwise
+     * @return true if the calibration has started, false if the group does not exist or another calibration is in progress
      */
     bool removeOffset(1: string actuatorGroup);
+
+    /**
+     * Get the progress of the offset calibration.
+     * If no calibration is in progress, the state is idle and the other fields refer to the last calibration.
+     * @return the status of the calibration
+     */
+    CalibrationStatus getCalibrationStatus();
+
+    /**
+     * Get the rate of the actuation commands not sent thanks to the delta output.
+     * @return the number of saved commands per second, 0 if the delta output is disabled
+     */
+    double getSavedCommandsRate();
+
+    /**
+     * Get the names of the actuators in the order of the intensities sent on the vector output port.
+     * The order is fixed from the start of the module, reloadConfig does not change it while the vector output is used.
+     * @return the names of the actuators
+     */
+    list<string> getActuatorOrder();
+
+    /**
+     * Read again the actuator groups and the retargeting parameters from the configuration file,
+     * and replace the current ones between two cycles. The control boards are opened again only if the joints changed.
+     * With the vector output, the new configuration must have the same actuators in the same order.
+     * @return true if the procedure was successful, false if the new configuration is not valid or cannot be applied and the current one is kept
+     */
+    bool reloadConfig();
+
+    /**
+     * Get the latency statistics of the stages from the joint sample to the haptic command,
+     * accumulated since the start of the module or since the last reset.
+     * @return the statistics of each stage
+     */
+    list<LatencyStageStats> getLatencyStats();
+
+    /**
+     * Get the statistics of the read time of each control board, with the name of the board as stage,
+     * accumulated since the start of the module or since the last reset.
+     * @return the statistics of each board, empty if the boards are not read in parallel
+     */
+    list<LatencyStageStats> getBoardReadStats();
+
+    /**
+     * Clear the latency statistics, including the ones of the control boards.
+     * @return true if the procedure was successful, false otherwise
+     */
+    bool resetLatencyStats();
 }
@@ -0,0 +1,177 @@
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <yarp/os/Bottle.h>
+#include <yarp/os/Property.h>
+
+#include "AllocationCounter.h"
+#include "BatchedActuationCommand.h"
+#include "WeightRetargetingCore.h"
+
+namespace
+{
+    // Groups with a filter, a nonlinear curve and a predictor, so that all of the stages of the control cycle run
+    const std::string CONTROL_CYCLE_CONFIG =
+        "(min_intensity 10.0)"
+        "(actuator_groups ("
+        "(\"left_arm\" (\"l_wrist_pitch\" \"l_wrist_yaw\") 0.1 1.5 (\"13@1\" \"13@2\" \"13@4\"))"
+        "(\"right_arm\" (\"r_wrist_pitch\" \"r_wrist_yaw\") 0.1 1.5 (\"14@3\" \"14@4\" \"14@6\"))"
+        "(\"left_elbow\" \"l_elbow\" 0.1 1.0 (\"13@5\"))"
+        "))"
+        "(group_filters ((\"all\" \"median\" 5) (\"all\" \"hysteresis\" 2.0)))"
+        "(group_curves ((\"left_arm\" \"power\" 0.67)))"
+        "(predictor \"kalman\") (prediction_horizon 0.05)";
+
+    bool configureCore(WeightRetargetingCore& core, const std::string& config)
+    {
+        yarp::os::Property property;
+        property.fromString(config);
+        return core.configure(property);
+    }
+
+    void fillBatchedCommand(const WeightRetargetingCore& core, const std::vector<WeightRetargetingCore::ActuationCommand>& commands,
+                            const BatchedActuationCommand::ActuatorNames& actuatorNames, BatchedActuationCommand& batchedCommand)
+    {
+        batchedCommand.clear(actuatorNames);
+        for(const WeightRetargetingCore::ActuationCommand& command : commands)
+            batchedCommand.add(command.actuator - core.groups.actuators.data(), command.intensity);
+    }
+
+    /**
+     * @brief Stand-in of a receiver of the batched output, which reads the message as a Bottle
+     *
+     * @param message the received message
+     * @param commands the (actuator, intensity) pairs of the message
+     * @return true if the message is a list of (<actuator_name> <intensity>) pairs
+     * @return false otherwise
+     */
+    bool parseBatchedCommand(const yarp::os::Bottle& message, std::vector<std::pair<std::string, double>>& commands)
+    {
+        commands.clear();
+        for(size_t i=0; i<message.size(); i++)
+        {
+            yarp::os::Bottle* command = message.get(i).asList();
+            if(command==nullptr || command->size()!=2 || !command->get(0).isString() || !command->get(1).isFloat64())
+                return false;
+            commands.emplace_back(command->get(0).asString(), command->get(1).asFloat64());
+        }
+        return true;
+    }
+}
+
+TEST_CASE("A receiver reads the batched output as a Bottle of (actuator, intensity) pairs", "[BatchedActuationCommand]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, CONTROL_CYCLE_CONFIG));
+    const BatchedActuationCommand::ActuatorNames actuatorNames = std::make_shared<const std::vector<std::string>>(core.groups.actuators);
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    BatchedActuationCommand batchedCommand;
+    std::vector<std::pair<std::string, double>> receivedCommands;
+
+    SECTION("the commands of a cycle")
+    {
+        const std::vector<double> interfaceValues{0.9, 0.3, 0.1, 0.1, 0.8};
+        core.generateGroupsActuation(interfaceValues, std::vector<double>(interfaceValues.size(), 0.0), 0.0, commands);
+        REQUIRE(commands.size()==4);
+        fillBatchedCommand(core, commands, actuatorNames, batchedCommand);
+
+        yarp::os::Bottle message;
+        REQUIRE(yarp::os::Portable::copyPortable(batchedCommand, message));
+        INFO("received " << message.toString());
+        REQUIRE(parseBatchedCommand(message, receivedCommands));
+        REQUIRE(receivedCommands.size()==commands.size());
+        for(size_t i=0; i<commands.size(); i++)
+        {
+            CHECK(receivedCommands[i].first==*commands[i].actuator);
+            CHECK(receivedCommands[i].second==commands[i].intensity);
+        }
+        CHECK(receivedCommands[0].first=="iFeelSuit::haptic::Node#13@1");
+        CHECK(receivedCommands[3].first=="iFeelSuit::haptic::Node#13@5");
+
+        // the message is read back with the names taken from it
+        BatchedActuationCommand receivedBatchedCommand;
+        REQUIRE(yarp::os::Portable::copyPortable(batchedCommand, receivedBatchedCommand));
+        REQUIRE(receivedBatchedCommand.size()==commands.size());
+        for(size_t i=0; i<commands.size(); i++)
+        {
+            CHECK(receivedBatchedCommand.getActuator(i)==*commands[i].actuator);
+            CHECK(receivedBatchedCommand.getIntensity(i)==commands[i].intensity);
+        }
+    }
+
+    SECTION("a reused message")
+    {
+        batchedCommand.clear(actuatorNames);
+        for(size_t actuator=0; actuator<actuatorNames->size(); actuator++)
+            batchedCommand.add(actuator, 100.0);
+        batchedCommand.clear(actuatorNames);
+        batchedCommand.add(6, 12.0);
+        batchedCommand.add(0, 127.0);
+
+        yarp::os::Bottle message;
+        REQUIRE(yarp::os::Portable::copyPortable(batchedCommand, message));
+        REQUIRE(parseBatchedCommand(message, receivedCommands));
+        REQUIRE(receivedCommands.size()==2);
+        CHECK(receivedCommands[0]==std::make_pair(std::string("iFeelSuit::haptic::Node#13@5"), 12.0));
+        CHECK(receivedCommands[1]==std::make_pair(std::string("iFeelSuit::haptic::Node#13@1"), 127.0));
+    }
+
+    SECTION("an empty message")
+    {
+        batchedCommand.clear(actuatorNames);
+        yarp::os::Bottle message;
+        REQUIRE(yarp::os::Portable::copyPortable(batchedCommand, message));
+        CHECK(message.size()==0);
+    }
+
+    SECTION("a message which is not a list of pairs")
+    {
+        yarp::os::Bottle message;
+        message.addString("iFeelSuit::haptic::Node#13@1");
+        message.addFloat64(10.0);
+        BatchedActuationCommand receivedBatchedCommand;
+        CHECK_FALSE(yarp::os::Portable::copyPortable(message, receivedBatchedCommand));
+    }
+}
+
+TEST_CASE("The control cycle with the batched output does not allocate", "[BatchedActuationCommand][AllocationCounter]")
+{
+    if(!AllocationCounter::isEnabled())
+    {
+        WARN("The allocations are counted only if the project is built with WEIGHT_RETARGETING_COUNT_ALLOCATIONS");
+        return;
+    }
+
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, CONTROL_CYCLE_CONFIG));
+    const BatchedActuationCommand::ActuatorNames actuatorNames = std::make_shared<const std::vector<std::string>>(core.groups.actuators);
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    commands.reserve(core.groups.actuators.size());
+    BatchedActuationCommand batchedCommand;
+
+    // the inputs of the ticks alternate all of the groups on and all of them off
+    const std::vector<double> velocities(core.jointNames.size(), 0.0);
+    const std::vector<double> activeValues(core.jointNames.size(), 1.0);
+    const std::vector<double> inactiveValues(core.jointNames.size(), 0.0);
+
+    // the first message with all of the actuators reaches the capacity of the message
+    core.generateGroupsActuation(activeValues, velocities, 0.0, commands);
+    fillBatchedCommand(core, commands, actuatorNames, batchedCommand);
+    REQUIRE(batchedCommand.size()==core.groups.actuators.size());
+
+    const size_t allocationCount = AllocationCounter::getThreadCount();
+    size_t sentCommands = 0;
+    for(int tick=1; tick<=200; tick++)
+    {
+        const std::vector<double>& interfaceValues = (tick/20)%2==0 ? activeValues : inactiveValues;
+        core.generateGroupsActuation(interfaceValues, velocities, 0.01*tick, 0.01*tick-0.02, commands);
+        fillBatchedCommand(core, commands, actuatorNames, batchedCommand);
+        sentCommands += batchedCommand.size();
+    }
+    CHECK(AllocationCounter::getThreadCount()-allocationCount==0);
+    CHECK(sentCommands>0);
+}
@@ -0,0 +1,225 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <yarp/os/Property.h>
+
+#include "GroupFilter.h"
+#include "WeightRetargetingCore.h"
+
+namespace
+{
+    // A single group whose intensity is about 100 times its norm, with the given filters
+    std::string getSingleGroupConfig(const std::string& filters)
+    {
+        return "(min_intensity 50.0)"
+               "(actuator_groups ((\"left_arm\" \"l_elbow\" 0.0 1.27 (\"13@1\"))))"
+               "(group_filters (" + filters + "))";
+    }
+
+    bool configureCore(WeightRetargetingCore& core, const std::string& config)
+    {
+        yarp::os::Property property;
+        property.fromString(config);
+        return core.configure(property);
+    }
+
+    // Run a tick of the control cycle with the value of the joint, returning whether the group is active
+    bool isActive(WeightRetargetingCore& core, const double value, std::vector<WeightRetargetingCore::ActuationCommand>& commands)
+    {
+        core.generateGroupsActuation({value}, {0.0}, 0.0, commands);
+        return !commands.empty();
+    }
+
+    // Number of on/off transitions of the group over a signal
+    int countTransitions(WeightRetargetingCore& core, const std::vector<double>& signal)
+    {
+        std::vector<WeightRetargetingCore::ActuationCommand> commands;
+        int transitions = 0;
+        bool active = false;
+        for(const double value : signal)
+        {
+            const bool newActive = isActive(core, value, commands);
+            if(newActive!=active)
+                transitions++;
+            active = newActive;
+        }
+        return transitions;
+    }
+}
+
+TEST_CASE("The group filters reject the invalid parameters", "[GroupFilter]")
+{
+    GroupFilter filter;
+    CHECK(GroupFilter::typeFromString("moving_average")==GroupFilter::Type::MovingAverage);
+    CHECK(GroupFilter::typeFromString("kalman")==GroupFilter::Type::Invalid);
+
+    CHECK_FALSE(filter.configure(GroupFilter::Type::LowPass, 0.0));
+    CHECK_FALSE(filter.configure(GroupFilter::Type::LowPass, 1.5));
+    CHECK_FALSE(filter.configure(GroupFilter::Type::MovingAverage, 0.0));
+    CHECK_FALSE(filter.configure(GroupFilter::Type::Median, 2.5));
+    CHECK_FALSE(filter.configure(GroupFilter::Type::Median, GroupFilter::MAX_WINDOW+1));
+    CHECK_FALSE(filter.configure(GroupFilter::Type::Invalid, 1.0));
+    CHECK(filter.getType()==GroupFilter::Type::None);
+    CHECK(filter.apply(3.5)==3.5);
+}
+
+TEST_CASE("The low-pass filter follows a step exponentially", "[GroupFilter]")
+{
+    const double alpha = 0.2;
+    GroupFilter filter;
+    REQUIRE(filter.configure(GroupFilter::Type::LowPass, alpha));
+
+    // the first sample initializes the filter, without a ramp from zero
+    CHECK(filter.apply(0.0)==0.0);
+    double previous = 0.0;
+    for(int sample=1; sample<=30; sample++)
+    {
+        const double output = filter.apply(1.0);
+        INFO("sample " << sample);
+        CHECK(output==Approx(1.0-std::pow(1.0-alpha, sample)));
+        CHECK(output>previous);
+        previous = output;
+    }
+    CHECK(previous==Approx(1.0).margin(0.01));
+
+    // reset restarts from the next sample
+    filter.reset();
+    CHECK(filter.apply(-2.0)==-2.0);
+}
+
+TEST_CASE("The moving average reaches a step after its window", "[GroupFilter]")
+{
+    const size_t window = 4;
+    GroupFilter filter;
+    REQUIRE(filter.configure(GroupFilter::Type::MovingAverage, window));
+
+    for(int sample=0; sample<10; sample++)
+        CHECK(filter.apply(2.0)==Approx(2.0));
+
+    // the step is ramped over the window, then it is reached exactly
+    for(size_t sample=1; sample<=window; sample++)
+        CHECK(filter.apply(6.0)==Approx(2.0+4.0*sample/window));
+    for(int sample=0; sample<100; sample++)
+        CHECK(filter.apply(6.0)==6.0);
+
+    // the average of the partial window is used after a reset
+    filter.reset();
+    CHECK(filter.apply(1.0)==1.0);
+    CHECK(filter.apply(3.0)==2.0);
+}
+
+TEST_CASE("The median filter rejects the outliers", "[GroupFilter]")
+{
+    GroupFilter filter;
+    REQUIRE(filter.configure(GroupFilter::Type::Median, 5));
+
+    SECTION("isolated spikes")
+    {
+        const std::vector<double> signal{1.0, 1.0, 1.0, 1.0, 1.0, 40.0, 1.0, 1.0, -30.0, 1.0, 1.0, 50.0, 45.0, 1.0, 1.0, 1.0};
+        for(size_t sample=0; sample<signal.size(); sample++)
+        {
+            INFO("sample " << sample);
+            CHECK(filter.apply(signal[sample])==1.0);
+        }
+    }
+
+    SECTION("step")
+    {
+        for(int sample=0; sample<5; sample++)
+            filter.apply(1.0);
+
+        // the step passes once it fills more than half of the window
+        CHECK(filter.apply(3.0)==1.0);
+        CHECK(filter.apply(3.0)==1.0);
+        CHECK(filter.apply(3.0)==3.0);
+        CHECK(filter.apply(3.0)==3.0);
+    }
+
+    SECTION("noisy signal with spikes")
+    {
+        // a constant norm with gaussian noise and sparse spikes of a faulty sensor
+        std::mt19937 generator(3);
+        std::normal_distribution<double> noise(0.0, 0.05);
+        double maxError = 0.0;
+        for(int sample=0; sample<1000; sample++)
+        {
+            const double value = sample%37==0 ? 20.0 : 2.0+noise(generator);
+            const double output = filter.apply(value);
+            if(sample>=5)
+                maxError = std::max(maxError, std::abs(output-2.0));
+        }
+        CHECK(maxError<0.25);
+    }
+}
+
+TEST_CASE("The hysteresis holds the on/off decision of the groups", "[GroupFilter][WeightRetargetingCore]")
+{
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+
+    SECTION("crossing and re-crossing the threshold")
+    {
+        // the group turns on above 60 and off below 40
+        WeightRetargetingCore core;
+        REQUIRE(configureCore(core, getSingleGroupConfig("(\"left_arm\" \"hysteresis\" 10.0)")));
+
+        CHECK_FALSE(isActive(core, 0.555, commands)); // 55, above min_intensity but within the band
+        CHECK(isActive(core, 0.655, commands)); // 65, it turns on
+        REQUIRE(commands.size()==1);
+        CHECK(commands[0].intensity==65.0);
+        CHECK(isActive(core, 0.455, commands)); // 45, below min_intensity but within the band
+        CHECK(commands[0].intensity==45.0);
+        CHECK_FALSE(isActive(core, 0.355, commands)); // 35, it turns off
+        CHECK_FALSE(isActive(core, 0.555, commands)); // 55, it re-crosses min_intensity but stays off
+        CHECK(isActive(core, 0.655, commands)); // 65, it turns on again
+    }
+
+    SECTION("without the hysteresis")
+    {
+        WeightRetargetingCore core;
+        REQUIRE(configureCore(core, getSingleGroupConfig("(\"left_arm\" \"median\" 1)")));
+
+        CHECK(isActive(core, 0.555, commands));
+        CHECK_FALSE(isActive(core, 0.455, commands));
+        CHECK(isActive(core, 0.555, commands));
+    }
+
+    SECTION("noisy signal around the threshold")
+    {
+        // a slow ramp up and down crossing min_intensity, with a noise smaller than the band
+        std::mt19937 generator(11);
+        std::uniform_real_distribution<double> noise(-0.05, 0.05);
+        std::vector<double> signal;
+        for(int sample=0; sample<400; sample++)
+        {
+            const double ramp = sample<200 ? 0.3+0.4*sample/200.0 : 0.7-0.4*(sample-200)/200.0;
+            signal.push_back(ramp+noise(generator));
+        }
+
+        WeightRetargetingCore filteredCore;
+        REQUIRE(configureCore(filteredCore, getSingleGroupConfig("(\"left_arm\" \"hysteresis\" 8.0)")));
+        CHECK(countTransitions(filteredCore, signal)==2);
+
+        WeightRetargetingCore unfilteredCore;
+        REQUIRE(configureCore(unfilteredCore, getSingleGroupConfig("(\"left_arm\" \"median\" 1)")));
+        CHECK(countTransitions(unfilteredCore, signal)>2);
+    }
+
+    SECTION("median filter and hysteresis combined")
+    {
+        // a spike does not turn the group on, a sustained value does
+        WeightRetargetingCore core;
+        REQUIRE(configureCore(core, getSingleGroupConfig("(\"all\" \"median\" 3) (\"all\" \"hysteresis\" 10.0)")));
+
+        CHECK_FALSE(isActive(core, 0.1, commands));
+        CHECK_FALSE(isActive(core, 0.1, commands));
+        CHECK_FALSE(isActive(core, 1.0, commands));
+        CHECK_FALSE(isActive(core, 0.1, commands));
+        CHECK_FALSE(isActive(core, 0.1, commands));
+        CHECK_FALSE(isActive(core, 1.0, commands));
+        CHECK(isActive(core, 1.0, commands));
+    }
+}
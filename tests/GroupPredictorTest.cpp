@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+
+#include <catch2/catch.hpp>
+
+#include "GroupPredictor.h"
+
+namespace
+{
+    const double PERIOD = 0.01; // [s] period of the samples of the norms
+    const double LEAD = 0.05; // [s] time ahead of the samples to be predicted
+    const double PI = 3.141592653589793;
+
+    /**
+     * @brief Errors of the predicted norms with respect to the true future norms
+     */
+    struct PredictionErrors
+    {
+        double max{0.0};
+        double rms{0.0};
+        double holdRms{0.0}; // rms error of holding the latest sample, that is without prediction
+    };
+
+    double ramp(const double time) { return 1.0 + 2.0*time; }
+
+    double sine(const double time) { return 5.0 + 2.0*std::sin(2.0*PI*0.5*time); }
+
+    /**
+     * @brief Predict a signal sampled for 10 s with a gaussian noise, the errors are evaluated after the first second
+     */
+    PredictionErrors evaluate(GroupPredictor& predictor, const std::function<double(double)>& signal, const double noise)
+    {
+        std::mt19937 generator(17);
+        std::normal_distribution<double> noiseDistribution(0.0, 1.0);
+        PredictionErrors errors;
+        double squares = 0.0;
+        double holdSquares = 0.0;
+        int count = 0;
+        for(int sample=0; sample<1000; sample++)
+        {
+            const double time = sample*PERIOD;
+            const double prediction = predictor.apply(signal(time)+noise*noiseDistribution(generator), time, LEAD);
+            if(time<1.0)
+                continue;
+
+            const double error = prediction-signal(time+LEAD);
+            const double holdError = signal(time)-signal(time+LEAD);
+            errors.max = std::max(errors.max, std::abs(error));
+            squares += error*error;
+            holdSquares += holdError*holdError;
+            count++;
+        }
+        errors.rms = std::sqrt(squares/count);
+        errors.holdRms = std::sqrt(holdSquares/count);
+        return errors;
+    }
+}
+
+TEST_CASE("The group predictors reject the invalid parameters", "[GroupPredictor]")
+{
+    GroupPredictor predictor;
+    CHECK(GroupPredictor::typeFromString("kalman")==GroupPredictor::Type::Kalman);
+    CHECK(GroupPredictor::typeFromString("median")==GroupPredictor::Type::Invalid);
+
+    CHECK_FALSE(predictor.configureLinear(1));
+    CHECK_FALSE(predictor.configureLinear(GroupPredictor::MAX_WINDOW+1));
+    CHECK_FALSE(predictor.configureKalman(0.0, 0.01));
+    CHECK_FALSE(predictor.configureKalman(1.0, -1.0));
+    CHECK(predictor.getType()==GroupPredictor::Type::None);
+    CHECK(predictor.apply(2.5, 0.0, LEAD)==2.5);
+}
+
+TEST_CASE("The group predictors extrapolate a ramp exactly", "[GroupPredictor]")
+{
+    GroupPredictor linear;
+    REQUIRE(linear.configureLinear(5));
+    GroupPredictor kalman;
+    REQUIRE(kalman.configureKalman(1.0, 0.01));
+
+    const PredictionErrors linearErrors = evaluate(linear, ramp, 0.0);
+    CHECK(linearErrors.max<1e-9);
+    const PredictionErrors kalmanErrors = evaluate(kalman, ramp, 0.0);
+    CHECK(kalmanErrors.max<1e-9);
+    CHECK(kalmanErrors.holdRms==Approx(2.0*LEAD));
+}
+
+TEST_CASE("The group predictors track a sine", "[GroupPredictor]")
+{
+    // without prediction the error is up to the amplitude times the angular frequency times the lead, about 0.31
+    SECTION("linear least-squares")
+    {
+        // the line fitted over 5 samples lags by half of its span, the error comes from the curvature of the sine
+        GroupPredictor predictor;
+        REQUIRE(predictor.configureLinear(5));
+        const PredictionErrors errors = evaluate(predictor, sine, 0.0);
+        INFO("max " << errors.max << ", rms " << errors.rms << ", hold rms " << errors.holdRms);
+        CHECK(errors.max<0.06);
+        CHECK(errors.rms<0.25*errors.holdRms);
+    }
+
+    SECTION("Kalman")
+    {
+        // the process noise must allow the slope of the sine to change, up to 20 norm/s^2
+        GroupPredictor predictor;
+        REQUIRE(predictor.configureKalman(100.0, 0.0025));
+        const PredictionErrors errors = evaluate(predictor, sine, 0.0);
+        INFO("max " << errors.max << ", rms " << errors.rms << ", hold rms " << errors.holdRms);
+        CHECK(errors.max<0.08);
+        CHECK(errors.rms<0.25*errors.holdRms);
+    }
+}
+
+TEST_CASE("The Kalman predictor filters the noise of the norms", "[GroupPredictor]")
+{
+    SECTION("noisy ramp")
+    {
+        // the default parameters, with a noise of 0.05 on the norms
+        GroupPredictor kalman;
+        REQUIRE(kalman.configureKalman(1.0, 0.01));
+        const PredictionErrors kalmanErrors = evaluate(kalman, ramp, 0.05);
+        INFO("max " << kalmanErrors.max << ", rms " << kalmanErrors.rms);
+        CHECK(kalmanErrors.max<0.1);
+        CHECK(kalmanErrors.rms<0.04);
+
+        // the short line of the linear predictor amplifies the noise instead
+        GroupPredictor linear;
+        REQUIRE(linear.configureLinear(5));
+        CHECK(evaluate(linear, ramp, 0.05).rms>2.0*kalmanErrors.rms);
+    }
+
+    SECTION("noisy sine")
+    {
+        GroupPredictor kalman;
+        REQUIRE(kalman.configureKalman(10.0, 0.0025));
+        const PredictionErrors errors = evaluate(kalman, sine, 0.05);
+        INFO("max " << errors.max << ", rms " << errors.rms << ", hold rms " << errors.holdRms);
+        CHECK(errors.max<0.25);
+        CHECK(errors.rms<0.5*errors.holdRms);
+    }
+}
+
+TEST_CASE("The group predictors handle the repeated timestamps and the negative predictions", "[GroupPredictor]")
+{
+    GroupPredictor predictor;
+    REQUIRE(predictor.configureLinear(4));
+
+    CHECK(predictor.apply(1.0, 0.0, LEAD)==1.0);
+    CHECK(predictor.apply(2.0, 0.1, LEAD)==Approx(2.5));
+
+    // a sample with the same timestamp replaces the previous one
+    CHECK(predictor.apply(3.0, 0.1, LEAD)==Approx(4.0));
+
+    // a falling norm is not predicted below zero
+    CHECK(predictor.apply(0.0, 0.2, 1.0)==0.0);
+
+    // the state restarts after a reset
+    predictor.reset();
+    CHECK(predictor.apply(7.0, 5.0, LEAD)==7.0);
+}
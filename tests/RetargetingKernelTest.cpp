@@ -0,0 +1,295 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "RetargetingKernel.h"
+
+namespace
+{
+    /**
+     * @brief Actuator groups and inputs of the kernel, with the layout of the group table
+     */
+    struct KernelInputs
+    {
+        size_t numberOfJoints{0};
+        std::vector<int> jointOffsets{0};
+        std::vector<int> jointIndexes;
+        std::vector<double> interfaceValues;
+        std::vector<double> offsets;
+        std::vector<double> minThresholds;
+        std::vector<double> maxThresholds;
+
+        size_t getNumberOfGroups() const { return jointOffsets.size()-1; }
+
+        void addGroup(const std::vector<int>& joints, const double offset, const double minThreshold, const double maxThreshold)
+        {
+            jointIndexes.insert(jointIndexes.end(), joints.begin(), joints.end());
+            jointOffsets.push_back(jointIndexes.size());
+            offsets.push_back(offset);
+            minThresholds.push_back(minThreshold);
+            maxThresholds.push_back(maxThreshold);
+        }
+    };
+
+    // Instruction sets supported by the running CPU, the scalar one first
+    std::vector<RetargetingKernel::InstructionSet> getSupportedInstructionSets()
+    {
+        std::vector<RetargetingKernel::InstructionSet> instructionSets{RetargetingKernel::InstructionSet::Scalar};
+        const RetargetingKernel::InstructionSet detected = RetargetingKernel::detectInstructionSet();
+        if(detected==RetargetingKernel::InstructionSet::SSE2 || detected==RetargetingKernel::InstructionSet::AVX2)
+            instructionSets.push_back(RetargetingKernel::InstructionSet::SSE2);
+        if(detected==RetargetingKernel::InstructionSet::AVX2)
+            instructionSets.push_back(RetargetingKernel::InstructionSet::AVX2);
+        return instructionSets;
+    }
+
+    std::vector<double> compute(const KernelInputs& inputs, const RetargetingKernel::InstructionSet instructionSet)
+    {
+        RetargetingKernel kernel;
+        kernel.configure(inputs.jointOffsets, inputs.jointIndexes, inputs.numberOfJoints, instructionSet);
+        std::vector<double> intensities(inputs.getNumberOfGroups());
+        kernel.compute(inputs.interfaceValues.data(), inputs.offsets.data(), inputs.minThresholds.data(), inputs.maxThresholds.data(), intensities.data());
+        return intensities;
+    }
+
+    // Intensity of a group computed with the formula of a single group
+    double computeReference(const KernelInputs& inputs, const size_t group)
+    {
+        double sum = 0;
+        for(int i=inputs.jointOffsets[group]; i<inputs.jointOffsets[group+1]; i++)
+        {
+            const double value = inputs.interfaceValues[inputs.jointIndexes[i]];
+            sum += value * value;
+        }
+        return RetargetingKernel::computeActuationIntensity(std::sqrt(sum)+inputs.offsets[group], inputs.minThresholds[group], inputs.maxThresholds[group]);
+    }
+
+    bool isBitIdentical(const double a, const double b)
+    {
+        return std::memcmp(&a, &b, sizeof(double))==0;
+    }
+
+    // Check that every implementation gives the intensities of the reference formula, bit for bit
+    void checkAllInstructionSets(const KernelInputs& inputs)
+    {
+        for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+        {
+            const std::vector<double> intensities = compute(inputs, instructionSet);
+            for(size_t group=0; group<inputs.getNumberOfGroups(); group++)
+            {
+                INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet) << ", group " << group << " of " << inputs.getNumberOfGroups());
+                const double reference = computeReference(inputs, group);
+                CHECK(isBitIdentical(intensities[group], reference));
+            }
+        }
+    }
+
+    // Intensities of the groups computed by a kernel for each group, so that no norm is shared
+    std::vector<double> computeWithoutSharing(const KernelInputs& inputs, const RetargetingKernel::InstructionSet instructionSet)
+    {
+        std::vector<double> intensities(inputs.getNumberOfGroups());
+        for(size_t group=0; group<inputs.getNumberOfGroups(); group++)
+        {
+            const std::vector<int> jointOffsets{0, inputs.jointOffsets[group+1]-inputs.jointOffsets[group]};
+            const std::vector<int> jointIndexes(inputs.jointIndexes.begin()+inputs.jointOffsets[group], inputs.jointIndexes.begin()+inputs.jointOffsets[group+1]);
+            RetargetingKernel kernel;
+            kernel.configure(jointOffsets, jointIndexes, inputs.numberOfJoints, instructionSet);
+            REQUIRE(kernel.getNumberOfNorms()==1);
+            kernel.compute(inputs.interfaceValues.data(), &inputs.offsets[group], &inputs.minThresholds[group], &inputs.maxThresholds[group], &intensities[group]);
+        }
+        return intensities;
+    }
+
+    // Check that sharing the norms does not change the norms and the intensities of the groups, bit for bit
+    void checkSharedNorms(const KernelInputs& inputs)
+    {
+        for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+        {
+            RetargetingKernel kernel;
+            kernel.configure(inputs.jointOffsets, inputs.jointIndexes, inputs.numberOfJoints, instructionSet);
+            std::vector<double> groupNorms(inputs.getNumberOfGroups());
+            kernel.computeNorms(inputs.interfaceValues.data(), groupNorms.data());
+            std::vector<double> intensities(inputs.getNumberOfGroups());
+            kernel.computeIntensities(groupNorms.data(), inputs.offsets.data(), inputs.minThresholds.data(), inputs.maxThresholds.data(), intensities.data());
+
+            const std::vector<double> unsharedIntensities = computeWithoutSharing(inputs, instructionSet);
+            for(size_t group=0; group<inputs.getNumberOfGroups(); group++)
+            {
+                INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet) << ", group " << group << " of " << inputs.getNumberOfGroups());
+                double sum = 0;
+                for(int i=inputs.jointOffsets[group]; i<inputs.jointOffsets[group+1]; i++)
+                    sum += inputs.interfaceValues[inputs.jointIndexes[i]] * inputs.interfaceValues[inputs.jointIndexes[i]];
+                CHECK(isBitIdentical(groupNorms[group], std::sqrt(sum)));
+                CHECK(isBitIdentical(intensities[group], unsharedIntensities[group]));
+            }
+        }
+    }
+
+    /**
+     * @brief Generate random groups over random joints, some of them sharing the list of joints of the previous group
+     */
+    KernelInputs generateInputs(std::mt19937& generator, const size_t numberOfGroups)
+    {
+        std::uniform_int_distribution<int> numberOfJointsDistribution(1, 40);
+        std::uniform_int_distribution<int> groupSizeDistribution(1, 6);
+        std::uniform_int_distribution<int> percentDistribution(0, 99);
+        std::uniform_real_distribution<double> valueDistribution(-50.0, 50.0);
+
+        KernelInputs inputs;
+        inputs.numberOfJoints = numberOfJointsDistribution(generator);
+        std::uniform_int_distribution<int> jointDistribution(0, inputs.numberOfJoints-1);
+        std::vector<int> joints;
+        for(size_t group=0; group<numberOfGroups; group++)
+        {
+            if(group==0 || percentDistribution(generator)>=30)
+            {
+                joints.resize(groupSizeDistribution(generator));
+                for(int& joint : joints)
+                    joint = jointDistribution(generator);
+            }
+            const double minThreshold = valueDistribution(generator);
+            const double maxThreshold = percentDistribution(generator)<10 ? minThreshold : valueDistribution(generator);
+            inputs.addGroup(joints, valueDistribution(generator)/10.0, minThreshold, maxThreshold);
+        }
+
+        inputs.interfaceValues.resize(inputs.numberOfJoints);
+        for(double& value : inputs.interfaceValues)
+            value = percentDistribution(generator)<3 ? std::numeric_limits<double>::quiet_NaN() : valueDistribution(generator);
+        return inputs;
+    }
+}
+
+TEST_CASE("The vectorized kernels match the scalar formula on random groups", "[RetargetingKernel]")
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> numberOfGroupsDistribution(1, 37);
+    for(int trial=0; trial<500; trial++)
+    {
+        INFO("trial " << trial);
+        checkAllInstructionSets(generateInputs(generator, numberOfGroupsDistribution(generator)));
+    }
+}
+
+TEST_CASE("The vectorized kernels handle the tails shorter than the vector width", "[RetargetingKernel]")
+{
+    // every number of groups up to three full AVX2 vectors plus a tail
+    std::mt19937 generator(7);
+    for(size_t numberOfGroups=1; numberOfGroups<=15; numberOfGroups++)
+    {
+        INFO("number of groups " << numberOfGroups);
+        checkAllInstructionSets(generateInputs(generator, numberOfGroups));
+    }
+}
+
+TEST_CASE("The vectorized kernels handle NaN values", "[RetargetingKernel]")
+{
+    KernelInputs inputs;
+    inputs.numberOfJoints = 3;
+    inputs.interfaceValues = {std::numeric_limits<double>::quiet_NaN(), 1.0, 2.0};
+    inputs.addGroup({0}, 0.0, 0.0, 1.0);
+    inputs.addGroup({0, 1}, 0.0, 0.0, 1.0);
+    inputs.addGroup({1, 2}, std::numeric_limits<double>::quiet_NaN(), 0.0, 1.0);
+    inputs.addGroup({1}, 0.0, std::numeric_limits<double>::quiet_NaN(), 1.0);
+    inputs.addGroup({2}, 0.0, 0.0, std::numeric_limits<double>::quiet_NaN());
+
+    checkAllInstructionSets(inputs);
+    for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+    {
+        INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet));
+        // a NaN anywhere in the computation disables the group
+        for(const double intensity : compute(inputs, instructionSet))
+            CHECK(intensity==0.0);
+    }
+}
+
+TEST_CASE("The vectorized kernels handle equal min and max thresholds", "[RetargetingKernel]")
+{
+    KernelInputs inputs;
+    inputs.numberOfJoints = 1;
+    inputs.interfaceValues = {2.0};
+    inputs.addGroup({0}, 0.0, 1.0, 1.0); // above the thresholds
+    inputs.addGroup({0}, 0.0, 3.0, 3.0); // below the thresholds
+    inputs.addGroup({0}, 0.0, 2.0, 2.0); // at the thresholds
+
+    checkAllInstructionSets(inputs);
+    for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+    {
+        INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet));
+        const std::vector<double> intensities = compute(inputs, instructionSet);
+        CHECK(intensities[0]==WEIGHT_RETARGETING_MAX_INTENSITY);
+        CHECK(intensities[1]==0.0);
+        CHECK(intensities[2]==0.0);
+    }
+}
+
+TEST_CASE("The vectorized kernels clamp the intensities", "[RetargetingKernel]")
+{
+    KernelInputs inputs;
+    inputs.numberOfJoints = 2;
+    inputs.interfaceValues = {3.0, 4.0}; // norm 5
+    inputs.addGroup({0, 1}, 0.0, 0.0, 1.0); // above the max threshold
+    inputs.addGroup({0, 1}, 0.0, 10.0, 20.0); // below the min threshold
+    inputs.addGroup({0, 1}, -5.0, 0.0, 1.0); // at the min threshold once the offset is removed
+    inputs.addGroup({0, 1}, 0.0, 20.0, 10.0); // inverted thresholds, below the max one
+    inputs.addGroup({0, 1}, 0.0, 0.0, 10.0); // halfway
+    inputs.addGroup({0, 1}, 0.0, -1e300, 1e300); // huge range
+
+    checkAllInstructionSets(inputs);
+    for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+    {
+        INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet));
+        const std::vector<double> intensities = compute(inputs, instructionSet);
+        CHECK(intensities[0]==WEIGHT_RETARGETING_MAX_INTENSITY);
+        CHECK(intensities[1]==0.0);
+        CHECK(intensities[2]==0.0);
+        CHECK(intensities[3]==WEIGHT_RETARGETING_MAX_INTENSITY);
+        CHECK(intensities[4]==static_cast<int>(0.5*WEIGHT_RETARGETING_MAX_INTENSITY));
+        CHECK(intensities[5]==static_cast<int>(0.5*WEIGHT_RETARGETING_MAX_INTENSITY));
+    }
+}
+
+TEST_CASE("The shared norms match the norms computed for each group", "[RetargetingKernel]")
+{
+    SECTION("overlapping groups")
+    {
+        // the layout of WeightRetargeting_iCub3_torques.ini, plus groups overlapping on some joints
+        KernelInputs inputs;
+        inputs.numberOfJoints = 5;
+        inputs.interfaceValues = {-31.5, 12.25, -29.0, 27.75, 0.1};
+        inputs.addGroup({0}, 0.0, -27.2, -38.0); // left_biceps
+        inputs.addGroup({0}, 0.0, 10.5, 15.5); // left_triceps
+        inputs.addGroup({2}, 0.0, -27.2, -38.0); // right_biceps
+        inputs.addGroup({2}, 0.0, 10.5, 15.5); // right_triceps
+        inputs.addGroup({3}, 0.0, 22.3, 32.0); // right_shoulder
+        inputs.addGroup({1}, 0.0, 22.3, 32.0); // left_shoulder
+        inputs.addGroup({0, 1}, 1.0, 20.0, 40.0);
+        inputs.addGroup({1, 4}, 0.0, 5.0, 15.0);
+        inputs.addGroup({0, 1}, -1.0, 20.0, 40.0); // same joints of a previous group
+        inputs.addGroup({1, 0}, 0.0, 20.0, 40.0); // same joints in another order, not shared
+
+        for(const RetargetingKernel::InstructionSet instructionSet : getSupportedInstructionSets())
+        {
+            INFO("instruction set " << RetargetingKernel::instructionSetToString(instructionSet));
+            RetargetingKernel kernel;
+            kernel.configure(inputs.jointOffsets, inputs.jointIndexes, inputs.numberOfJoints, instructionSet);
+            CHECK(kernel.getNumberOfNorms()==7);
+        }
+        checkSharedNorms(inputs);
+    }
+
+    SECTION("random groups")
+    {
+        // about a third of the random groups share the list of joints of the previous group
+        std::mt19937 generator(1234);
+        std::uniform_int_distribution<int> numberOfGroupsDistribution(1, 37);
+        for(int trial=0; trial<200; trial++)
+        {
+            INFO("trial " << trial);
+            checkSharedNorms(generateInputs(generator, numberOfGroupsDistribution(generator)));
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <yarp/os/Property.h>
+
+#include "RetargetingLayouts.h"
+#include "TickRecording.h"
+#include "WeightRetargetingCore.h"
+
+namespace
+{
+    bool isBitIdentical(const double a, const double b)
+    {
+        return std::memcmp(&a, &b, sizeof(double))==0;
+    }
+}
+
+TEST_CASE("The specialized control cycle matches the generic one on the iCub3 layouts", "[RetargetingLayouts]")
+{
+    // the layouts specialized at build time, with a recording of their joints in the test data
+    const std::string layout = GENERATE(as<std::string>{}, "WeightRetargeting_iCub3", "WeightRetargeting_iCub3_torques");
+    INFO("layout " << layout);
+
+    yarp::os::Property config;
+    REQUIRE(config.fromConfigFile(std::string(WEIGHT_RETARGETING_CONF_DIR) + "/" + layout + ".ini"));
+    WeightRetargetingCore generic;
+    REQUIRE(generic.configure(config));
+    WeightRetargetingCore specialized;
+    REQUIRE(specialized.configure(config));
+    REQUIRE(selectSpecializedStages(specialized));
+    CHECK(specialized.specializedStages.layout==layout);
+    REQUIRE(specialized.specializedStages.computeNorms!=nullptr);
+    REQUIRE(specialized.specializedStages.checkVelocities!=nullptr);
+
+    TickRecording recording;
+    std::string error;
+    REQUIRE(recording.open(std::string(WEIGHT_RETARGETING_TEST_DATA_DIR) + "/" + layout + ".ticks", error));
+    const TickRecordingHeader& header = recording.getHeader();
+    REQUIRE(header.numberOfValues==generic.getNumberOfValues());
+    REQUIRE(header.numberOfVelocities==generic.getNumberOfValues());
+
+    std::vector<double> interfaceValues(header.numberOfValues);
+    std::vector<double> velocities(header.numberOfVelocities);
+    std::vector<WeightRetargetingCore::ActuationCommand> genericCommands;
+    std::vector<WeightRetargetingCore::ActuationCommand> specializedCommands;
+    size_t differentNorms = 0;
+    size_t differentVelocityChecks = 0;
+    size_t differentCommands = 0;
+    size_t sentCommands = 0;
+    size_t rejectedGroups = 0;
+    for(size_t tick=0; tick<recording.size(); tick++)
+    {
+        interfaceValues.assign(recording.getValues(tick), recording.getValues(tick)+header.numberOfValues);
+        velocities.assign(recording.getVelocities(tick), recording.getVelocities(tick)+header.numberOfVelocities);
+        generic.generateGroupsActuation(interfaceValues, velocities, recording.getTime(tick), genericCommands);
+        specialized.generateGroupsActuation(interfaceValues, velocities, recording.getTime(tick), specializedCommands);
+
+        for(size_t group=0; group<generic.groups.size(); group++)
+        {
+            if(!isBitIdentical(generic.groupNorms[group], specialized.groupNorms[group]) || !isBitIdentical(generic.intensities[group], specialized.intensities[group]))
+                differentNorms++;
+            if(generic.groupVelocityAllowed[group]!=specialized.groupVelocityAllowed[group])
+                differentVelocityChecks++;
+            if(!generic.groupVelocityAllowed[group])
+                rejectedGroups++;
+        }
+
+        if(genericCommands.size()!=specializedCommands.size())
+        {
+            differentCommands++;
+            continue;
+        }
+        for(size_t i=0; i<genericCommands.size(); i++)
+        {
+            // the actuators are compared by their index in the group tables of the two cores
+            const bool sameActuator = genericCommands[i].actuator-generic.groups.actuators.data()==specializedCommands[i].actuator-specialized.groups.actuators.data();
+            if(!sameActuator || !isBitIdentical(genericCommands[i].intensity, specializedCommands[i].intensity))
+                differentCommands++;
+        }
+        sentCommands += genericCommands.size();
+    }
+
+    CHECK(differentNorms==0);
+    CHECK(differentVelocityChecks==0);
+    CHECK(differentCommands==0);
+
+    // the recording exercises both the commands and the velocity check
+    CHECK(sentCommands>0);
+    CHECK(rejectedGroups>0);
+}
@@ -0,0 +1,115 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "SnapshotBuffer.h"
+
+namespace
+{
+    // Snapshot whose values are all equal to its version, so that a torn snapshot has different values
+    struct VersionedSnapshot
+    {
+        long version{0};
+        std::vector<long> values;
+    };
+
+    bool isConsistent(const VersionedSnapshot& snapshot)
+    {
+        for(const long value : snapshot.values)
+        {
+            if(value!=snapshot.version)
+                return false;
+        }
+        return true;
+    }
+
+    bool publishNextVersion(VersionedSnapshot& snapshot)
+    {
+        snapshot.version++;
+        for(long& value : snapshot.values)
+            value = snapshot.version;
+        return true;
+    }
+}
+
+TEST_CASE("The snapshot buffer publishes the updates", "[SnapshotBuffer]")
+{
+    SnapshotBuffer<VersionedSnapshot> buffer;
+    buffer.initialize(VersionedSnapshot{0, std::vector<long>(4, 0)});
+
+    CHECK(buffer.acquire().version==0);
+    buffer.release();
+
+    // a discarded update does not change the snapshot
+    CHECK_FALSE(buffer.update([](VersionedSnapshot& snapshot){ snapshot.version = 10; return false; }));
+    CHECK(buffer.get().version==0);
+
+    // the pinned snapshot does not change until it is released
+    const VersionedSnapshot& pinned = buffer.acquire();
+    for(int i=0; i<5; i++)
+        CHECK(buffer.update(publishNextVersion));
+    CHECK(pinned.version==0);
+    CHECK(isConsistent(pinned));
+    buffer.release();
+
+    CHECK(buffer.acquire().version==5);
+    buffer.release();
+    CHECK(buffer.tryUpdate(publishNextVersion));
+    CHECK(buffer.get().version==6);
+}
+
+TEST_CASE("The reader of the snapshot buffer never sees a torn snapshot", "[SnapshotBuffer]")
+{
+    const int NUMBER_OF_WRITERS = 3;
+    const int UPDATES_PER_WRITER = 20000;
+
+    SnapshotBuffer<VersionedSnapshot> buffer;
+    buffer.initialize(VersionedSnapshot{0, std::vector<long>(64, 0)});
+
+    std::atomic<int> runningWriters{NUMBER_OF_WRITERS};
+    std::vector<std::thread> writers;
+    for(int writer=0; writer<NUMBER_OF_WRITERS; writer++)
+    {
+        writers.emplace_back([&buffer, &runningWriters, UPDATES_PER_WRITER]()
+        {
+            for(int update=0; update<UPDATES_PER_WRITER; update++)
+                buffer.update(publishNextVersion);
+            runningWriters--;
+        });
+    }
+
+    // the reader runs as the control cycle, also publishing some updates when no writer is publishing
+    long tornSnapshots = 0;
+    long decreasingVersions = 0;
+    long reads = 0;
+    long readerUpdates = 0;
+    long lastVersion = 0;
+    while(runningWriters.load()>0)
+    {
+        const VersionedSnapshot& snapshot = buffer.acquire();
+        if(!isConsistent(snapshot))
+            tornSnapshots++;
+        if(snapshot.version<lastVersion)
+            decreasingVersions++;
+        lastVersion = snapshot.version;
+        buffer.release();
+        reads++;
+
+        if(reads%100==0 && buffer.tryUpdate(publishNextVersion))
+            readerUpdates++;
+    }
+    for(std::thread& writer : writers)
+        writer.join();
+
+    INFO(reads << " reads, " << readerUpdates << " updates of the reader");
+    CHECK(tornSnapshots==0);
+    CHECK(decreasingVersions==0);
+    CHECK(reads>0);
+
+    // every update has been published exactly once
+    const VersionedSnapshot latest = buffer.get();
+    CHECK(isConsistent(latest));
+    CHECK(latest.version==NUMBER_OF_WRITERS*UPDATES_PER_WRITER+readerUpdates);
+}
@@ -0,0 +1,143 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <yarp/os/Property.h>
+
+#include "RetargetingLayouts.h"
+#include "WeightRetargetingCore.h"
+
+namespace
+{
+    /**
+     * @brief Configuration of a suit-sized retargeting: groups of one to four joints with two actuators each,
+     * a third of them sharing the joints of the previous group
+     */
+    std::string generateConfig(const size_t numberOfGroups, const size_t numberOfJoints)
+    {
+        std::string config = "(min_intensity 10.0) (actuator_groups (";
+        std::string joints;
+        for(size_t group=0; group<numberOfGroups; group++)
+        {
+            if(group%3!=2)
+            {
+                joints.clear();
+                for(size_t joint=0; joint<1+group%4; joint++)
+                    joints += "\"joint" + std::to_string((group+joint)%numberOfJoints) + "\" ";
+            }
+            config += "(\"group" + std::to_string(group) + "\" (" + joints + ") 0.1 2.0 (\"" + std::to_string(group) + "@1\" \"" + std::to_string(group) + "@2\")) ";
+        }
+        return config + "))";
+    }
+
+    void benchmarkCore(const std::string& name, const std::string& config)
+    {
+        WeightRetargetingCore core;
+        yarp::os::Property property;
+        property.fromString(config);
+        REQUIRE(core.configure(property));
+
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> valueDistribution(-1.0, 1.0);
+        std::vector<double> interfaceValues(core.jointNames.size());
+        for(double& value : interfaceValues)
+            value = valueDistribution(generator);
+        const std::vector<double> velocities(core.jointNames.size(), 0.0);
+        std::vector<WeightRetargetingCore::ActuationCommand> commands;
+
+        double time = 0.0;
+        BENCHMARK(name.c_str())
+        {
+            time += 0.01;
+            core.generateGroupsActuation(interfaceValues, velocities, time, commands);
+            return commands.size();
+        };
+    }
+}
+
+TEST_CASE("Control cycle of the retargeting core", "[!benchmark][WeightRetargetingCore]")
+{
+    const std::string config = generateConfig(32, 24);
+    benchmarkCore("32 groups", config);
+    benchmarkCore("32 groups, median filter", config+"(group_filters ((\"all\" \"median\" 5)))");
+    benchmarkCore("32 groups, power curve", config+"(group_curves ((\"all\" \"power\" 0.67)))");
+    benchmarkCore("32 groups, Kalman predictor", config+"(predictor \"kalman\") (prediction_horizon 0.05)");
+    benchmarkCore("128 groups", generateConfig(128, 64));
+}
+
+TEST_CASE("Batch kernel of the retargeting core", "[!benchmark][RetargetingKernel]")
+{
+    WeightRetargetingCore core;
+    yarp::os::Property property;
+    property.fromString(generateConfig(128, 64));
+    REQUIRE(core.configure(property));
+
+    std::vector<double> interfaceValues(core.jointNames.size(), 0.5);
+    const WeightRetargetingCore::GroupParameters parameters = core.parameters.get();
+    std::vector<double> intensities(core.groups.size());
+    for(const RetargetingKernel::InstructionSet instructionSet : {RetargetingKernel::InstructionSet::Scalar, RetargetingKernel::InstructionSet::SSE2, RetargetingKernel::InstructionSet::AVX2})
+    {
+        if(static_cast<int>(instructionSet)>static_cast<int>(RetargetingKernel::detectInstructionSet()))
+            continue;
+
+        RetargetingKernel kernel;
+        kernel.configure(core.groups.jointOffsets, core.groups.jointIndexes, core.jointNames.size(), instructionSet);
+        BENCHMARK(("128 groups, " + RetargetingKernel::instructionSetToString(instructionSet)).c_str())
+        {
+            kernel.compute(interfaceValues.data(), parameters.offsets.data(), parameters.minThresholds.data(), parameters.maxThresholds.data(), intensities.data());
+            return intensities[0];
+        };
+    }
+}
+
+TEST_CASE("Specialized stages of the iCub3 layouts", "[!benchmark][RetargetingLayouts]")
+{
+    for(const std::string layout : {"WeightRetargeting_iCub3", "WeightRetargeting_iCub3_torques"})
+    {
+        yarp::os::Property config;
+        REQUIRE(config.fromConfigFile(std::string(WEIGHT_RETARGETING_CONF_DIR) + "/" + layout + ".ini"));
+        WeightRetargetingCore generic;
+        REQUIRE(generic.configure(config));
+        WeightRetargetingCore specialized;
+        REQUIRE(specialized.configure(config));
+        REQUIRE(selectSpecializedStages(specialized));
+
+        std::mt19937 generator(1);
+        std::uniform_real_distribution<double> valueDistribution(-1.0, 1.0);
+        std::vector<double> interfaceValues(generic.jointNames.size());
+        for(double& value : interfaceValues)
+            value = valueDistribution(generator);
+        const std::vector<double> velocities(generic.jointNames.size(), 0.0);
+        std::vector<double> groupNorms(generic.groups.size());
+
+        // the norms alone, which are unrolled over the joints of the layout
+        BENCHMARK((layout + ", norms, generic").c_str())
+        {
+            generic.kernel.computeNorms(interfaceValues.data(), groupNorms.data());
+            return groupNorms[0];
+        };
+        BENCHMARK((layout + ", norms, specialized").c_str())
+        {
+            specialized.specializedStages.computeNorms(interfaceValues.data(), groupNorms.data());
+            return groupNorms[0];
+        };
+
+        // the whole control cycle, whose filters, intensities and commands stay generic
+        std::vector<WeightRetargetingCore::ActuationCommand> commands;
+        double time = 0.0;
+        BENCHMARK((layout + ", control cycle, generic").c_str())
+        {
+            time += 0.01;
+            generic.generateGroupsActuation(interfaceValues, velocities, time, commands);
+            return commands.size();
+        };
+        BENCHMARK((layout + ", control cycle, specialized").c_str())
+        {
+            time += 0.01;
+            specialized.generateGroupsActuation(interfaceValues, velocities, time, commands);
+            return commands.size();
+        };
+    }
+}
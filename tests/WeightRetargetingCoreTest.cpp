@@ -0,0 +1,288 @@
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include <yarp/os/Property.h>
+
+#include "WeightRetargetingCore.h"
+
+namespace
+{
+    // Two groups: left_arm on two joints with two actuators, right_arm on one joint with one actuator
+    const std::string GROUPS_CONFIG =
+        "(min_intensity 20.0)"
+        "(actuator_groups ("
+        "(\"left_arm\" (\"l_wrist_pitch\" \"l_wrist_yaw\") 0.45 1.5 (\"13@1\" \"13@2\"))"
+        "(\"right_arm\" \"r_wrist_pitch\" 0.0 1.0 (\"14@3\"))"
+        "))";
+
+    bool configureCore(WeightRetargetingCore& core, const std::string& config)
+    {
+        yarp::os::Property property;
+        property.fromString(config);
+        return core.configure(property);
+    }
+
+    double getIntensity(const double norm, const double minThreshold, const double maxThreshold)
+    {
+        return WeightRetargetingCore::computeActuationIntensity(norm, minThreshold, maxThreshold);
+    }
+}
+
+TEST_CASE("The core reads the actuator groups", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, GROUPS_CONFIG));
+
+    CHECK(core.groups.names==std::vector<std::string>{"left_arm", "right_arm"});
+    CHECK(core.jointNames==std::vector<std::string>{"l_wrist_pitch", "l_wrist_yaw", "r_wrist_pitch"});
+    const WeightRetargetingCore::GroupParameters parameters = core.parameters.get();
+    CHECK(parameters.minThresholds==std::vector<double>{0.45, 0.0});
+    CHECK(parameters.maxThresholds==std::vector<double>{1.5, 1.0});
+    CHECK(parameters.offsets==std::vector<double>{0.0, 0.0});
+    CHECK(core.groups.jointOffsets==std::vector<int>{0, 2, 3});
+    CHECK(core.groups.jointIndexes==std::vector<int>{0, 1, 2});
+    CHECK(core.groups.actuatorOffsets==std::vector<int>{0, 2, 3});
+    CHECK(core.groups.actuators==std::vector<std::string>{"iFeelSuit::haptic::Node#13@1", "iFeelSuit::haptic::Node#13@2", "iFeelSuit::haptic::Node#14@3"});
+    CHECK(core.minIntensity==20.0);
+    CHECK_FALSE(core.useWeight);
+    CHECK(core.getNumberOfValues()==3);
+
+    size_t index = 0;
+    CHECK(core.getGroupIndex("right_arm", index));
+    CHECK(index==1);
+    CHECK_FALSE(core.getGroupIndex("left_leg", index));
+}
+
+TEST_CASE("The core rejects the invalid actuator groups", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore missingGroups;
+    CHECK_FALSE(configureCore(missingGroups, "(min_intensity 20.0)"));
+
+    WeightRetargetingCore reservedName;
+    CHECK_FALSE(configureCore(reservedName, "(actuator_groups ((\"all\" \"j\" 0.0 1.0 (\"1@1\"))))"));
+
+    WeightRetargetingCore duplicatedName;
+    CHECK_FALSE(configureCore(duplicatedName, "(actuator_groups ((\"g\" \"j\" 0.0 1.0 (\"1@1\")) (\"g\" \"k\" 0.0 1.0 (\"1@2\"))))"));
+
+    WeightRetargetingCore missingThreshold;
+    CHECK_FALSE(configureCore(missingThreshold, "(actuator_groups ((\"g\" \"j\" 0.0 (\"1@1\"))))"));
+
+    WeightRetargetingCore noActuators;
+    CHECK_FALSE(configureCore(noActuators, "(actuator_groups ((\"g\" \"j\" 0.0 1.0 ())))"));
+
+    WeightRetargetingCore notAList;
+    CHECK_FALSE(configureCore(notAList, "(actuator_groups (\"g\" \"j\" 0.0 1.0 (\"1@1\")))"));
+}
+
+TEST_CASE("The core generates the commands of the active groups", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, GROUPS_CONFIG));
+
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    const std::vector<double> velocities(3, 0.0);
+
+    SECTION("all of the groups above the min intensity")
+    {
+        core.generateGroupsActuation({0.6, 0.8, 0.5}, velocities, 0.0, commands);
+        REQUIRE(commands.size()==3);
+        CHECK(*commands[0].actuator=="iFeelSuit::haptic::Node#13@1");
+        CHECK(*commands[1].actuator=="iFeelSuit::haptic::Node#13@2");
+        CHECK(*commands[2].actuator=="iFeelSuit::haptic::Node#14@3");
+        CHECK(commands[0].intensity==getIntensity(1.0, 0.45, 1.5));
+        CHECK(commands[1].intensity==getIntensity(1.0, 0.45, 1.5));
+        CHECK(commands[2].intensity==getIntensity(0.5, 0.0, 1.0));
+    }
+
+    SECTION("a group below the min intensity")
+    {
+        core.generateGroupsActuation({0.3, 0.4, 1.0}, velocities, 0.0, commands);
+        REQUIRE(commands.size()==1);
+        CHECK(*commands[0].actuator=="iFeelSuit::haptic::Node#14@3");
+        CHECK(commands[0].intensity==WEIGHT_RETARGETING_MAX_INTENSITY);
+    }
+
+    SECTION("the batch computation matches the single group one")
+    {
+        const std::vector<double> interfaceValues{0.7, -0.2, 0.35};
+        core.generateGroupsActuation(interfaceValues, velocities, 0.0, commands);
+        const WeightRetargetingCore::GroupParameters parameters = core.parameters.get();
+        REQUIRE(commands.size()==3);
+        CHECK(commands[0].intensity==core.computeActuationIntensity(0, parameters, interfaceValues, velocities));
+        CHECK(commands[2].intensity==core.computeActuationIntensity(1, parameters, interfaceValues, velocities));
+    }
+
+    SECTION("the thresholds changed at runtime")
+    {
+        CHECK_FALSE(core.setThresholds("left_leg", 0.0, 1.0));
+        REQUIRE(core.setThresholds("left_arm", 0.0, 2.0));
+        REQUIRE(core.setMaxThreshold("right_arm", 0.5));
+        core.generateGroupsActuation({0.6, 0.8, 0.25}, velocities, 0.0, commands);
+        REQUIRE(commands.size()==3);
+        CHECK(commands[0].intensity==getIntensity(1.0, 0.0, 2.0));
+        CHECK(commands[2].intensity==getIntensity(0.25, 0.0, 0.5));
+    }
+}
+
+TEST_CASE("The core checks the velocities of the joints", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, GROUPS_CONFIG+"(use_velocity true) (max_velocity 0.1)"));
+    REQUIRE(core.useVelocities);
+
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    core.generateGroupsActuation({0.6, 0.8, 0.5}, {0.0, 0.2, 0.0}, 0.0, commands);
+    REQUIRE(commands.size()==1);
+    CHECK(*commands[0].actuator=="iFeelSuit::haptic::Node#14@3");
+
+    core.generateGroupsActuation({0.6, 0.8, 0.5}, {0.05, 0.0, 0.0}, 0.0, commands);
+    CHECK(commands.size()==3);
+}
+
+TEST_CASE("The delta output sends only the changed intensities", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, GROUPS_CONFIG+"(delta_output true) (keep_alive_period 1.0)"));
+
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    const std::vector<double> velocities(3, 0.0);
+    const std::vector<double> interfaceValues{0.6, 0.8, 0.5};
+
+    core.generateGroupsActuation(interfaceValues, velocities, 0.0, commands);
+    CHECK(commands.size()==3);
+
+    // unchanged intensities are suppressed until the keep-alive period expires
+    core.generateGroupsActuation(interfaceValues, velocities, 0.5, commands);
+    CHECK(commands.empty());
+    CHECK(core.suppressedCommands==3);
+    core.generateGroupsActuation(interfaceValues, velocities, 1.0, commands);
+    CHECK(commands.size()==3);
+
+    // an explicit zero is sent once when a group turns off
+    core.generateGroupsActuation({0.0, 0.0, 0.5}, velocities, 1.1, commands);
+    REQUIRE(commands.size()==2);
+    CHECK(commands[0].intensity==0.0);
+    CHECK(commands[1].intensity==0.0);
+    core.generateGroupsActuation({0.0, 0.0, 0.5}, velocities, 1.2, commands);
+    CHECK(commands.empty());
+}
+
+TEST_CASE("The calibration maps the baseline norm to the min threshold", "[WeightRetargetingCore]")
+{
+    WeightRetargetingCore core;
+    REQUIRE(configureCore(core, GROUPS_CONFIG+"(calibration_samples 3) (calibration_estimator \"median\")"));
+
+    CHECK_FALSE(core.removeOffset("left_leg"));
+    REQUIRE(core.removeOffset("left_arm"));
+    CHECK_FALSE(core.removeOffset("right_arm"));
+
+    std::vector<WeightRetargetingCore::ActuationCommand> commands;
+    const std::vector<double> velocities(3, 0.0);
+    const std::vector<double> norms{1.0, 5.0, 1.2};
+    for(size_t tick=0; tick<norms.size(); tick++)
+    {
+        CHECK(core.calibrationState.load()!=WeightRetargetingCore::CalibrationState::Idle);
+        core.generateGroupsActuation({norms[tick], 0.0, 0.0}, velocities, 0.01*tick, commands);
+    }
+    CHECK(core.calibrationState.load()==WeightRetargetingCore::CalibrationState::Idle);
+    CHECK(core.calibrationCollectedSamples.load()==3);
+
+    // the median rejects the outlier, the other group is not calibrated
+    const WeightRetargetingCore::GroupParameters parameters = core.parameters.get();
+    CHECK(parameters.offsets[0]==Approx(0.45-1.2));
+    CHECK(parameters.offsets[1]==0.0);
+}
+
+TEST_CASE("The display core computes the weight held by the inputs", "[WeightDisplayCore]")
+{
+    WeightDisplayCore core;
+    yarp::os::Property config;
+    config.fromString("(input_port_names (left_hand right_hand))");
+    REQUIRE(core.configure(config));
+    REQUIRE(core.inputNames==std::vector<std::string>{"left_hand", "right_hand"});
+
+    const double left[6] = {0.0, 0.0, -9.81, 0.0, 0.0, 0.0};
+    const double right[6] = {1.0, 2.0, -19.62, 0.0, 0.0, 0.0};
+    const double pushing[6] = {0.0, 0.0, 5.0, 0.0, 0.0, 0.0};
+
+    CHECK(core.computeWeight({left, right}, {})==Approx(3.0));
+    CHECK(core.computeWeight({left, nullptr}, {})==Approx(1.0));
+    CHECK(core.computeWeight({pushing, right}, {})==Approx(2.0));
+
+    // the input whose joints move too fast is ignored
+    core.useVelocity = true;
+    core.maxVelocity = 0.1;
+    core.inputJoints = {{0}, {1}};
+    CHECK(core.computeWeight({left, right}, {0.0, 0.2})==Approx(1.0));
+}
+
+TEST_CASE("The tare collects only the new wrenches of each input", "[WeightDisplayCore]")
+{
+    WeightDisplayCore core;
+    yarp::os::Property config;
+    config.fromString("(input_port_names (left_hand right_hand)) (tare_samples 3)");
+    REQUIRE(core.configure(config));
+    REQUIRE(core.requestTare("all"));
+    CHECK_FALSE(core.requestTare("left_hand"));
+
+    // the left input is updated at every tick, the right one every third tick as in the event-driven mode
+    std::vector<WeightDisplayCore::Wrench> leftWrenches;
+    std::vector<WeightDisplayCore::Wrench> rightWrenches;
+    for(int tick=0; tick<9; tick++)
+    {
+        leftWrenches.push_back({1.0+tick, 0.0, -10.0, 0.0, 0.0, 0.0});
+        if(tick%3==0)
+            rightWrenches.push_back({0.0, 2.0*tick, -20.0, 0.0, 0.0, 0.0});
+
+        core.updateTare({leftWrenches.back().data(), rightWrenches.back().data()}, {0.01*tick, 0.01*(tick-tick%3)}, 0.01*tick);
+        if(tick<6)
+            CHECK(core.tareState.load()!=WeightDisplayCore::TareState::Idle);
+    }
+
+    // the tare is done with the third wrench of the right input, the further wrenches of the left input are ignored
+    REQUIRE(core.tareState.load()==WeightDisplayCore::TareState::Idle);
+    CHECK(core.tareResult.load()==WeightDisplayCore::TareResult::Succeeded);
+    CHECK(core.tareCounts==std::vector<int>{3, 3});
+    CHECK(core.tareCollectedSamples.load()==3);
+    const WeightDisplayCore::DisplayParameters parameters = core.parameters.get();
+    CHECK(parameters.offsets[0][0]==Approx(2.0));
+    CHECK(parameters.offsets[1][1]==Approx(6.0));
+    CHECK(parameters.offsets[1][2]==Approx(-20.0));
+}
+
+TEST_CASE("The tare fails without publishing the offsets", "[WeightDisplayCore]")
+{
+    WeightDisplayCore core;
+    yarp::os::Property config;
+    config.fromString("(input_port_names (left_hand right_hand)) (tare_samples 3) (tare_max_deviation 0.5) (tare_timeout 0.1)");
+    REQUIRE(core.configure(config));
+    CHECK_FALSE(core.requestTare("unknown"));
+
+    SECTION("The wrenches of the input are not received in time")
+    {
+        const WeightDisplayCore::Wrench wrench{0.0, 0.0, -10.0, 0.0, 0.0, 0.0};
+        REQUIRE(core.requestTare("right_hand"));
+        for(int tick=0; tick<20 && core.tareState.load()!=WeightDisplayCore::TareState::Idle; tick++)
+            core.updateTare({wrench.data(), nullptr}, {0.01*tick, std::numeric_limits<double>::quiet_NaN()}, 0.01*tick);
+        CHECK(core.tareState.load()==WeightDisplayCore::TareState::Idle);
+        CHECK(core.tareResult.load()==WeightDisplayCore::TareResult::TimedOut);
+        CHECK(core.tareCollectedSamples.load()==0);
+    }
+
+    SECTION("The force of the input is not steady")
+    {
+        const WeightDisplayCore::Wrench wrenches[3] = {{0.0, 0.0, -10.0, 0.0, 0.0, 0.0}, {0.0, 0.0, -12.0, 0.0, 0.0, 0.0}, {0.0, 0.0, -8.0, 0.0, 0.0, 0.0}};
+        REQUIRE(core.requestTare("left_hand"));
+        for(int tick=0; tick<3; tick++)
+            core.updateTare({wrenches[tick].data(), nullptr}, {0.01*tick, 0.0}, 0.01*tick);
+        CHECK(core.tareState.load()==WeightDisplayCore::TareState::Idle);
+        CHECK(core.tareResult.load()==WeightDisplayCore::TareResult::Rejected);
+    }
+
+    const WeightDisplayCore::DisplayParameters parameters = core.parameters.get();
+    CHECK(parameters.offsets[0]==WeightDisplayCore::Wrench{});
+    CHECK(parameters.offsets[1]==WeightDisplayCore::Wrench{});
+}
@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <catch2/catch.hpp>
+
+#include "WrenchTimeSeries.h"
+
+namespace
+{
+    // Maximum age of a wrench to be used, as in WrenchAcquisition
+    const double STALENESS_WINDOW = 0.1;
+
+    // Wrench whose values are linear in the time of the source, so that the interpolation is exact
+    WrenchTimeSeries::Wrench getLinearWrench(const double time)
+    {
+        WrenchTimeSeries::Wrench wrench;
+        for(size_t i=0; i<WrenchTimeSeries::WRENCH_SIZE; i++)
+            wrench[i] = (i+1)*time - 2.0*i;
+        return wrench;
+    }
+
+    void push(WrenchTimeSeries& series, const double time, const double arrivalTime)
+    {
+        const WrenchTimeSeries::Wrench wrench = getLinearWrench(time);
+        series.push(time, wrench.data(), wrench.size(), arrivalTime);
+    }
+
+    bool isAvailable(const WrenchTimeSeries& series, const double time)
+    {
+        return !series.empty() && time-series.getLastArrivalTime()<=STALENESS_WINDOW;
+    }
+
+    // Check the interpolated wrench, the ends of the history are held outside of it
+    void checkInterpolation(const WrenchTimeSeries& series, const double time)
+    {
+        WrenchTimeSeries::Wrench wrench;
+        REQUIRE(series.interpolate(time, wrench));
+        const WrenchTimeSeries::Wrench expected = getLinearWrench(std::min(std::max(time, series.getOldestTime()), series.getNewestTime()));
+        for(size_t i=0; i<WrenchTimeSeries::WRENCH_SIZE; i++)
+            CHECK(wrench[i]==Approx(expected[i]).margin(1e-9));
+    }
+
+    /**
+     * @brief Sample of a stream, with the timestamp of the source and the local time of its arrival
+     */
+    struct Sample
+    {
+        double time;
+        double arrivalTime;
+    };
+
+    /**
+     * @brief Generate a stream sampled with a period, whose source clock has an offset from the local one
+     * and whose samples arrive with a random delay, so that some of them arrive out of order
+     */
+    std::vector<Sample> generateSkewedStream(std::mt19937& generator, const double period, const double clockOffset, const double maxDelay, const int numberOfSamples)
+    {
+        std::uniform_real_distribution<double> delayDistribution(0.0, maxDelay);
+        std::uniform_real_distribution<double> jitterDistribution(-0.2*period, 0.2*period);
+        std::vector<Sample> stream;
+        for(int i=0; i<numberOfSamples; i++)
+        {
+            const double localTime = i*period + jitterDistribution(generator);
+            stream.push_back({localTime+clockOffset, localTime+delayDistribution(generator)});
+        }
+        std::sort(stream.begin(), stream.end(), [](const Sample& a, const Sample& b){ return a.arrivalTime<b.arrivalTime; });
+        return stream;
+    }
+}
+
+TEST_CASE("The wrench time series interpolates the history", "[WrenchTimeSeries]")
+{
+    WrenchTimeSeries series;
+    series.configure(4);
+    WrenchTimeSeries::Wrench wrench;
+    CHECK_FALSE(series.interpolate(0.0, wrench));
+
+    push(series, 1.0, 10.0);
+    push(series, 1.1, 10.1);
+    push(series, 1.3, 10.2);
+    CHECK(series.size()==3);
+    checkInterpolation(series, 1.05);
+    checkInterpolation(series, 1.25);
+
+    // the ends of the history are held
+    REQUIRE(series.interpolate(0.5, wrench));
+    CHECK(wrench==getLinearWrench(1.0));
+    REQUIRE(series.interpolate(2.0, wrench));
+    CHECK(wrench==getLinearWrench(1.3));
+
+    // the oldest wrench is overwritten when the history is full
+    push(series, 1.4, 10.3);
+    push(series, 1.5, 10.4);
+    CHECK(series.size()==4);
+    CHECK(series.getOldestTime()==1.1);
+    CHECK(series.getNewestTime()==1.5);
+
+    // a wrench with the same timestamp replaces the newest one
+    const WrenchTimeSeries::Wrench replacement{1.0, 2.0, 3.0, 4.0, 5.0, 6.0};
+    series.push(1.5, replacement.data(), 3, 10.5);
+    CHECK(series.size()==4);
+    CHECK(series.getNewest()==WrenchTimeSeries::Wrench{1.0, 2.0, 3.0, 0.0, 0.0, 0.0});
+    CHECK(series.getLastArrivalTime()==10.5);
+}
+
+TEST_CASE("The wrench time series discards the wrenches out of order", "[WrenchTimeSeries]")
+{
+    WrenchTimeSeries series;
+    series.configure(8);
+    push(series, 2.0, 10.0);
+
+    // a late wrench is discarded and it does not refresh the arrival time
+    push(series, 1.9, 10.05);
+    CHECK(series.size()==1);
+    CHECK(series.getNewestTime()==2.0);
+    CHECK(series.getLastArrivalTime()==10.0);
+
+    // the input becomes stale even if the old wrenches keep arriving
+    for(int i=1; i<=20; i++)
+        push(series, 2.0-0.01*i, 10.0+0.01*i);
+    CHECK(series.getLastArrivalTime()==10.0);
+    CHECK(isAvailable(series, 10.0+STALENESS_WINDOW));
+    CHECK_FALSE(isAvailable(series, 10.2));
+
+    // a new wrench makes it available again
+    push(series, 2.01, 10.25);
+    CHECK(isAvailable(series, 10.3));
+}
+
+TEST_CASE("The wrench time series aligns skewed streams", "[WrenchTimeSeries]")
+{
+    // two streams at 100 Hz with different clock offsets, jitter and delays,
+    // aligned at the newest timestamp covered by both of them as in WrenchAcquisition
+    std::mt19937 generator(5);
+    const double period = 0.01;
+    const std::vector<Sample> firstStream = generateSkewedStream(generator, period, 0.0, 0.004, 500);
+    const std::vector<Sample> secondStream = generateSkewedStream(generator, period, -0.035, 0.025, 500);
+
+    WrenchTimeSeries firstSeries;
+    WrenchTimeSeries secondSeries;
+    firstSeries.configure(16);
+    secondSeries.configure(16);
+
+    size_t firstNext = 0;
+    size_t secondNext = 0;
+    int alignedTicks = 0;
+    int discarded = 0;
+    double lastCommonTime = -1.0;
+    for(int tick=1; tick<500; tick++)
+    {
+        const double time = tick*period;
+        for(; firstNext<firstStream.size() && firstStream[firstNext].arrivalTime<=time; firstNext++)
+            push(firstSeries, firstStream[firstNext].time, firstStream[firstNext].arrivalTime);
+        for(; secondNext<secondStream.size() && secondStream[secondNext].arrivalTime<=time; secondNext++)
+        {
+            const size_t size = secondSeries.size();
+            const double newestTime = secondSeries.empty() ? 0.0 : secondSeries.getNewestTime();
+            push(secondSeries, secondStream[secondNext].time, secondStream[secondNext].arrivalTime);
+            if(secondSeries.size()==size && secondSeries.getNewestTime()==newestTime)
+                discarded++;
+        }
+
+        if(!isAvailable(firstSeries, time) || !isAvailable(secondSeries, time))
+            continue;
+
+        // the history is ordered and the arrival time is the one of the last stored wrench
+        CHECK(secondSeries.getLastArrivalTime()<=time);
+        CHECK(secondSeries.getOldestTime()<=secondSeries.getNewestTime());
+
+        const double commonTime = std::min(firstSeries.getNewestTime(), secondSeries.getNewestTime());
+        CHECK(commonTime>=lastCommonTime);
+        lastCommonTime = commonTime;
+        INFO("tick " << tick << ", common time " << commonTime);
+        checkInterpolation(firstSeries, commonTime);
+        checkInterpolation(secondSeries, commonTime);
+        alignedTicks++;
+    }
+
+    // the delays of the second stream are longer than its period, so some of its wrenches arrive out of order
+    CHECK(discarded>0);
+    CHECK(alignedTicks>400);
+}